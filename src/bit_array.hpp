@@ -0,0 +1,252 @@
+#ifndef BIT_ARRAY_HPP
+#define BIT_ARRAY_HPP
+
+#include <stdint.h>
+
+// Default storage word: bytes on AVR, which has 8-bit registers, and 64-bit
+// words on the host, where the loops over words also vectorize.
+#if defined(__AVR__)
+using bit_word_t = uint8_t;
+#else
+using bit_word_t = uint64_t;
+#endif
+
+namespace bit_array_detail {
+
+template <class Word> constexpr uint8_t popcount(Word w) {
+  return sizeof(Word) <= sizeof(unsigned)        ? __builtin_popcount(w)
+         : sizeof(Word) <= sizeof(unsigned long) ? __builtin_popcountl(w)
+                                                 : __builtin_popcountll(w);
+}
+
+// @brief Leading zero bits of a non-zero w.
+template <class Word> constexpr uint8_t clz(Word w) {
+  return sizeof(Word) <= sizeof(unsigned)
+             ? __builtin_clz(w) - (sizeof(unsigned) - sizeof(Word)) * 8
+         : sizeof(Word) <= sizeof(unsigned long)
+             ? __builtin_clzl(w) - (sizeof(unsigned long) - sizeof(Word)) * 8
+             : __builtin_clzll(w) - (sizeof(unsigned long long) - sizeof(Word)) * 8;
+}
+
+} // namespace bit_array_detail
+
+/**
+ * BitArray object stores bits in the most space-efficient manner
+ * and does bitwise operations to them using big-endian word order:
+ * bit 0 is the most significant bit of the first word.
+ * Word is the storage type, uint8_t, uint16_t, uint32_t or uint64_t.
+ * Bits past Bits in the last word are kept zero.
+ * NOTE:
+ * With direct access to bit_array, do not modify bits outside your
+ * defined Bits count as it might cause undefined behaviour, especially
+ * with shift operators.
+ */
+template <uint16_t Bits, class Word = bit_word_t> class BitArray {
+public:
+  using word_t = Word;
+  using index_t = uint16_t;
+  using this_type = BitArray<Bits, Word>;
+
+  static const uint8_t WORD_BITS = sizeof(Word) * 8;
+  static const index_t WORD_LENGTH = (Bits - 1) / WORD_BITS + 1;
+
+  static_assert(Word(~Word(0)) > Word(0), "Word must be unsigned.");
+  static_assert(Bits > 0, "Bit-size must be > 0.");
+
+public:
+  constexpr BitArray() : bit_array{} {}
+
+  // @brief Returns an array with the bits set where bits[] is true.
+  static constexpr this_type from_bools(const bool (&bits)[Bits]) {
+    this_type result;
+    for (index_t i = 0; i < Bits; ++i)
+      if (bits[i])
+        result.set(i);
+    return result;
+  }
+
+  // @brief Access array data. Bounds not checked.
+  constexpr Word operator[](index_t idx) const { return bit_array[idx]; }
+
+  // @brief Access array data for writing. Bounds not checked, see the note
+  // at the top about bits past Bits.
+  constexpr Word &word(index_t idx) { return bit_array[idx]; }
+
+  // @brief Returns bit i. Bounds not checked.
+  constexpr bool test(index_t i) const {
+    return bit_array[i / WORD_BITS] & bit_mask(i);
+  }
+
+  // @brief Sets bit i to value. Bounds not checked.
+  constexpr void set(index_t i, bool value = true) {
+    if (value)
+      bit_array[i / WORD_BITS] |= bit_mask(i);
+    else
+      bit_array[i / WORD_BITS] &= Word(~bit_mask(i));
+  }
+
+  // @brief Clears every bit.
+  constexpr void clear() {
+    for (index_t i = 0; i < WORD_LENGTH; ++i)
+      bit_array[i] = 0;
+  }
+
+  // @brief Shifts bits left specified amount, towards bit 0.
+  // @param shift The amount to shift.
+  // @note Whole words move in one pass, the rest is shifted within the same
+  // pass.
+  constexpr void shift_left(index_t shift) {
+    if (shift >= Bits) {
+      clear();
+      return;
+    }
+    const index_t ws = shift / WORD_BITS;
+    const uint8_t bs = shift % WORD_BITS;
+    for (index_t i = 0; i < WORD_LENGTH - ws; ++i) {
+      Word w = bit_array[i + ws];
+      if (bs) {
+        w <<= bs;
+        if (i + ws + 1 < WORD_LENGTH)
+          w |= bit_array[i + ws + 1] >> (WORD_BITS - bs);
+      }
+      bit_array[i] = w;
+    }
+    for (index_t i = WORD_LENGTH - ws; i < WORD_LENGTH; ++i)
+      bit_array[i] = 0;
+  }
+
+  // @brief Shifts bits right specified amount, away from bit 0.
+  // @param shift The amount to shift.
+  constexpr void shift_right(index_t shift) {
+    if (shift >= Bits) {
+      clear();
+      return;
+    }
+    const index_t ws = shift / WORD_BITS;
+    const uint8_t bs = shift % WORD_BITS;
+    for (index_t i = WORD_LENGTH; i-- > ws;) {
+      Word w = bit_array[i - ws];
+      if (bs) {
+        w >>= bs;
+        if (i > ws)
+          w |= bit_array[i - ws - 1] << (WORD_BITS - bs);
+      }
+      bit_array[i] = w;
+    }
+    for (index_t i = 0; i < ws; ++i)
+      bit_array[i] = 0;
+    bit_array[WORD_LENGTH - 1] &= least_signf_word_mask();
+  }
+
+  // @brief Returns the number of set bits.
+  constexpr index_t count() const {
+    index_t n = 0;
+    for (index_t i = 0; i < WORD_LENGTH; ++i)
+      n += bit_array_detail::popcount(bit_array[i]);
+    return n;
+  }
+
+  // @brief Returns the index of the first set bit, bit_size() if none is.
+  constexpr index_t find_first() const {
+    for (index_t i = 0; i < WORD_LENGTH; ++i)
+      if (bit_array[i])
+        return i * WORD_BITS + bit_array_detail::clz(bit_array[i]);
+    return Bits;
+  }
+
+  constexpr bool any() const {
+    for (index_t i = 0; i < WORD_LENGTH; ++i)
+      if (bit_array[i])
+        return true;
+    return false;
+  }
+
+  // @brief Returns the amount of bytes used by the array.
+  constexpr index_t byte_size() const { return sizeof(bit_array); }
+
+  // @brief Returns the amount of storage words used by the array.
+  constexpr index_t word_size() const { return WORD_LENGTH; }
+
+  // @brief Returns the amount of bits in use.
+  // @note If bit_size() % WORD_BITS != 0, remaining bits can still
+  // be directly accessable and modifiable, but doing so is
+  // undefined under class specifications: please use least_signf_word()
+  // to access the last word and least_signf_word_mask() with &-operator
+  // to modify.
+  constexpr index_t bit_size() const { return Bits; }
+
+  // @brief Returns the mask used for modifying the least significant word.
+  static constexpr Word least_signf_word_mask() {
+    return Bits % WORD_BITS == 0 ? Word(~Word(0))
+                                 : Word(~Word(0) << (WORD_BITS - Bits % WORD_BITS));
+  }
+
+  // @brief Returns the least significant word using least_signf_word_mask()
+  // with &-operator.
+  constexpr Word least_signf_word() const {
+    return bit_array[WORD_LENGTH - 1] & least_signf_word_mask();
+  }
+
+  constexpr this_type &operator&=(const this_type &other) {
+    for (index_t i = 0; i < WORD_LENGTH; ++i)
+      bit_array[i] &= other.bit_array[i];
+    return *this;
+  }
+
+  constexpr this_type &operator|=(const this_type &other) {
+    for (index_t i = 0; i < WORD_LENGTH; ++i)
+      bit_array[i] |= other.bit_array[i];
+    return *this;
+  }
+
+  constexpr this_type &operator^=(const this_type &other) {
+    for (index_t i = 0; i < WORD_LENGTH; ++i)
+      bit_array[i] ^= other.bit_array[i];
+    return *this;
+  }
+
+  constexpr this_type &operator<<=(index_t shift) {
+    shift_left(shift);
+    return *this;
+  }
+
+  constexpr this_type &operator>>=(index_t shift) {
+    shift_right(shift);
+    return *this;
+  }
+
+  // @brief Inverts every bit inside defined bounds.
+  constexpr this_type operator~() const {
+    this_type result;
+    for (index_t i = 0; i < WORD_LENGTH; ++i)
+      result.bit_array[i] = ~bit_array[i];
+    result.bit_array[WORD_LENGTH - 1] &= least_signf_word_mask();
+    return result;
+  }
+
+  friend constexpr this_type operator&(this_type a, const this_type &b) { return a &= b; }
+  friend constexpr this_type operator|(this_type a, const this_type &b) { return a |= b; }
+  friend constexpr this_type operator^(this_type a, const this_type &b) { return a ^= b; }
+  friend constexpr this_type operator<<(this_type a, index_t shift) { return a <<= shift; }
+  friend constexpr this_type operator>>(this_type a, index_t shift) { return a >>= shift; }
+
+  friend constexpr bool operator==(const this_type &a, const this_type &b) {
+    for (index_t i = 0; i < WORD_LENGTH; ++i)
+      if (a.bit_array[i] != b.bit_array[i])
+        return false;
+    return true;
+  }
+
+  friend constexpr bool operator!=(const this_type &a, const this_type &b) { return !(a == b); }
+
+private:
+  static constexpr Word bit_mask(index_t i) {
+    return Word(Word(1) << (WORD_BITS - 1 - i % WORD_BITS));
+  }
+
+private:
+  // Storage array.
+  Word bit_array[WORD_LENGTH];
+};
+
+#endif
@@ -0,0 +1,277 @@
+#ifndef FRAMEBUFFER_HPP
+#define FRAMEBUFFER_HPP
+
+#include <stdint.h>
+#include <avr/pgmspace.h> // on the host, src/sim has a stand-in
+
+#include "bit_array.hpp"
+#include "pins.h"
+
+// Storage word of a W pixel row: a row of 16 is one uint16_t, as in the
+// screen[] of the clocks.
+template <uint8_t W, bool Wide = W % 16 == 0> struct fb_row_word {
+  using type = uint8_t;
+};
+template <uint8_t W> struct fb_row_word<W, true> {
+  using type = uint16_t;
+};
+
+// How the bits of a source row combine with the frame in Framebuffer::blit().
+enum BlitOp : uint8_t { BLIT_COPY, BLIT_OR, BLIT_XOR, BLIT_AND_NOT };
+
+// l_port word bit (first byte 0 - 7, second 8 - 15) of each column, from
+// pins.h as X[] in led.c.
+#define FB_PORT_BIT_OF(x, port, bit) PIN_WORD_BIT(x, port, bit),
+constexpr uint8_t FB_PORT_BIT[16] = {PINS_COLUMNS(FB_PORT_BIT_OF, )};
+#undef FB_PORT_BIT_OF
+
+// @brief l_port bits lit by each nibble of a 16 column row: bits[k][n] for
+// columns 4k - 4k+3 set as in n, column 4k in its top bit.
+struct FbPortTable {
+  uint16_t bits[4][16];
+};
+
+constexpr FbPortTable fb_port_table_make() {
+  FbPortTable t = {};
+  for (uint8_t k = 0; k < 4; ++k)
+    for (uint8_t n = 0; n < 16; ++n)
+      for (uint8_t c = 0; c < 4; ++c)
+        if (n & (8 >> c))
+          t.bits[k][n] |= uint16_t(1) << FB_PORT_BIT[4 * k + c];
+  return t;
+}
+
+const FbPortTable fb_port_table PROGMEM = fb_port_table_make();
+
+/**
+ * W x H frame of 1-bit pixels in a BitArray, row-major: row y is bits
+ * y*W - y*W+W-1 with x = 0 in the most significant bit, and starts on a new
+ * storage word. With W = 16 a row is the uint16_t of a screen[] row in
+ * real_clock.c and clock.c. Row operations work on whole words.
+ */
+template <uint8_t W, uint8_t H, class Word = typename fb_row_word<W>::type> class Framebuffer {
+public:
+  using bits_t = BitArray<W * H, Word>;
+  using row_t = BitArray<W, Word>;
+  using this_type = Framebuffer<W, H, Word>;
+
+  static const uint8_t WORD_BITS = sizeof(Word) * 8;
+  static const uint8_t ROW_WORDS = W / WORD_BITS;
+
+  static_assert(W % WORD_BITS == 0, "Rows must start on a storage word.");
+
+public:
+  constexpr Framebuffer() : bits() {}
+
+  constexpr uint8_t width() const { return W; }
+  constexpr uint8_t height() const { return H; }
+
+  // @brief The pixels as one BitArray.
+  constexpr const bits_t &bit_array() const { return bits; }
+  constexpr bits_t &bit_array() { return bits; }
+
+  // @brief Returns pixel x, y. Bounds not checked.
+  constexpr bool get(uint8_t x, uint8_t y) const { return bits.test(y * W + x); }
+
+  // @brief Sets pixel x, y to value. Bounds not checked.
+  constexpr void set(uint8_t x, uint8_t y, bool value = true) {
+    bits.set(y * W + x, value);
+  }
+
+  constexpr void clear() { bits.clear(); }
+
+  // @brief Returns row y.
+  constexpr row_t row(uint8_t y) const {
+    row_t r;
+    for (uint8_t i = 0; i < ROW_WORDS; ++i)
+      r.word(i) = bits[y * ROW_WORDS + i];
+    return r;
+  }
+
+  // @brief Replaces row y with r.
+  constexpr void set_row(uint8_t y, const row_t &r) {
+    for (uint8_t i = 0; i < ROW_WORDS; ++i)
+      bits.word(y * ROW_WORDS + i) = r[i];
+  }
+
+  // @brief Rotates row y n pixels right, negative n rotates left.
+  constexpr void rotate_row(uint8_t y, int8_t n) {
+    int16_t k = n % W;
+    if (k < 0)
+      k += W;
+    if (k == 0)
+      return;
+    row_t r = row(y);
+    set_row(y, (r >> k) | (r << (W - k)));
+  }
+
+  // @brief Rotates every row n pixels right, negative n rotates left.
+  constexpr void rotate_rows(int8_t n) {
+    for (uint8_t y = 0; y < H; ++y)
+      rotate_row(y, n);
+  }
+
+  // @brief Combines src into the frame with its top left corner at x, y.
+  // Whatever falls outside the frame is dropped.
+  template <uint8_t SW, uint8_t SH, class SWord>
+  constexpr void blit(const Framebuffer<SW, SH, SWord> &src, int8_t x, int8_t y,
+                      BlitOp op = BLIT_COPY) {
+    static_assert(SW <= W, "The source must not be wider than the frame.");
+    static_assert(sizeof(SWord) <= sizeof(Word),
+                  "The source words must not be wider than the frame's.");
+    const uint8_t src_bits = sizeof(SWord) * 8;
+    const uint8_t src_words = SW / src_bits;
+    row_t mask = ~row_t() << (W - SW);
+    place(mask, x);
+    for (uint8_t sy = 0; sy < SH; ++sy) {
+      int16_t dy = y + sy;
+      if (dy < 0 || dy >= H)
+        continue;
+      row_t r;
+      for (uint8_t i = 0; i < src_words; ++i) {
+        row_t w;
+        w.word(0) = Word(Word(src.bit_array()[sy * src_words + i]) << (WORD_BITS - src_bits));
+        r |= w >> (i * src_bits);
+      }
+      place(r, x);
+      row_t d = row(dy);
+      switch (op) {
+      case BLIT_COPY:
+        d = (d & ~mask) | r;
+        break;
+      case BLIT_OR:
+        d |= r;
+        break;
+      case BLIT_XOR:
+        d ^= r;
+        break;
+      case BLIT_AND_NOT:
+        d &= ~r;
+        break;
+      }
+      set_row(dy, d);
+    }
+  }
+
+  constexpr this_type &operator&=(const this_type &other) {
+    bits &= other.bits;
+    return *this;
+  }
+
+  constexpr this_type &operator|=(const this_type &other) {
+    bits |= other.bits;
+    return *this;
+  }
+
+  constexpr this_type &operator^=(const this_type &other) {
+    bits ^= other.bits;
+    return *this;
+  }
+
+  constexpr this_type operator~() const {
+    this_type result;
+    result.bits = ~bits;
+    return result;
+  }
+
+  friend constexpr this_type operator&(this_type a, const this_type &b) { return a &= b; }
+  friend constexpr this_type operator|(this_type a, const this_type &b) { return a |= b; }
+  friend constexpr this_type operator^(this_type a, const this_type &b) { return a ^= b; }
+
+  friend constexpr bool operator==(const this_type &a, const this_type &b) {
+    return a.bits == b.bits;
+  }
+
+  friend constexpr bool operator!=(const this_type &a, const this_type &b) {
+    return a.bits != b.bits;
+  }
+
+  // @brief Returns the number of lit pixels.
+  constexpr uint16_t count() const { return bits.count(); }
+
+  // @brief Returns row y as a screen[] row: x = 0 in bit 15.
+  constexpr uint16_t row16(uint8_t y) const {
+    static_assert(W == 16, "Only 16 pixel rows are screen[] rows.");
+    uint16_t r = 0;
+    for (uint8_t i = 0; i < ROW_WORDS; ++i)
+      r = uint16_t(uint32_t(r) << WORD_BITS) | bits[y * ROW_WORDS + i];
+    return r;
+  }
+
+  // @brief Writes the frame as the screen[] rows of the clocks.
+  constexpr void to_rows(uint16_t *rows) const {
+    for (uint8_t y = 0; y < H; ++y)
+      rows[y] = row16(y);
+  }
+
+  // @brief Returns a frame of the screen[] rows of the clocks.
+  static constexpr this_type from_rows(const uint16_t *rows) {
+    static_assert(W == 16, "Only 16 pixel rows are screen[] rows.");
+    this_type result;
+    for (uint8_t y = 0; y < H; ++y)
+      for (uint8_t i = 0; i < ROW_WORDS; ++i)
+        result.bits.word(y * ROW_WORDS + i) =
+            Word(rows[y] >> (16 - WORD_BITS * (i + 1)));
+    return result;
+  }
+
+  // @brief Returns a frame lit where levels[y * W + x] (l[] of led.c) is at
+  // least threshold.
+  static constexpr this_type from_levels(const uint8_t *levels, uint8_t threshold) {
+    this_type result;
+    for (uint8_t y = 0; y < H; ++y)
+      for (uint8_t i = 0; i < ROW_WORDS; ++i) {
+        Word w = 0;
+        for (uint8_t b = 0; b < WORD_BITS; ++b)
+          w = Word(w << 1) | (*levels++ >= threshold);
+        result.bits.word(y * ROW_WORDS + i) = w;
+      }
+    return result;
+  }
+
+  // @brief Returns row y as an l_port word of led.c, first byte in the low
+  // eight bits: the anodes of lit pixels low. A constant expression for the
+  // script compiler, to_l_port() reads the same from a flash table.
+  constexpr uint16_t port_word(uint8_t y) const {
+    static_assert(W == 16, "l_port rows are 16 columns.");
+    uint16_t r = row16(y);
+    uint16_t word = 0xffff;
+    for (uint8_t x = 0; x < 16; ++x)
+      if (r & (0x8000 >> x))
+        word &= ~(1 << FB_PORT_BIT[x]);
+    return word;
+  }
+
+  // @brief Writes the frame to every bitplane of port, l_port of led.c:
+  // lit pixels full on, the rest off. Four table reads a row. For l_port
+  // follow with l_relit(0xffff) and l_publish().
+  template <uint8_t Planes> void to_l_port(uint8_t (*port)[Planes][2]) const {
+    static_assert(W == 16, "l_port rows are 16 columns.");
+    for (uint8_t y = 0; y < H; ++y) {
+      uint16_t r = row16(y);
+      uint16_t lit = pgm_read_word(&fb_port_table.bits[0][r >> 12]) |
+                     pgm_read_word(&fb_port_table.bits[1][(r >> 8) & 0x0f]) |
+                     pgm_read_word(&fb_port_table.bits[2][(r >> 4) & 0x0f]) |
+                     pgm_read_word(&fb_port_table.bits[3][r & 0x0f]);
+      uint16_t off = ~lit; // the anodes are active low
+      for (uint8_t p = 0; p < Planes; ++p) {
+        port[y][p][0] = off & 0xff;
+        port[y][p][1] = off >> 8;
+      }
+    }
+  }
+
+private:
+  // @brief Moves r x pixels right, negative x moves it left.
+  static constexpr void place(row_t &r, int8_t x) {
+    if (x >= 0)
+      r >>= x;
+    else
+      r <<= -x;
+  }
+
+private:
+  bits_t bits;
+};
+
+#endif
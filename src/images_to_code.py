@@ -1,4 +1,14 @@
-from PIL import Image
+import re
+import sys
+
+# Converts frames into an animation script. Frames are written as changes
+# against the previous frame, with a full keyframe every KEYFRAME_INTERVAL
+# frames and at the start of every sequence.
+# With --blit every frame is written as a 'b' bitmap that animate() copies
+# straight to the display: more flash, but no per-pixel work.
+# Usage: python3 images_to_code.py [--blit]                read IMAGE_NAMES
+#        python3 images_to_code.py [--blit] --script FILE  re-encode a script of
+#                                                          full "e0f s... w... e00a" frames
 
 IMAGE_NAMES = ["0001.png", "0002.png", "0003.png", "0004.png", "0005.png", "0006.png", "0007.png",
                 "0008.png", "0009.png", "0010.png", "0011.png", "0012.png", "0013.png", "0014.png",
@@ -6,6 +16,8 @@ IMAGE_NAMES = ["0001.png", "0002.png", "0003.png", "0004.png", "0005.png", "0006
 
 LED_SIDE_LEN = 16
 SET_LED_THRESHOLD = 50
+FRAME_WAIT_MS = 195
+KEYFRAME_INTERVAL = 16
 
 # Returns hex number without the prefix "0x".
 def num_to_hex(number):
@@ -24,26 +36,82 @@ def set_led_effect_command(x, y):
   return "s" + num_to_hex(y) + num_to_hex(x)
 
 
+def set_leds_command(effect, pixels):
+  if not pixels:
+    return ""
+  return effect + "".join(set_led_effect_command(x, y) for (y, x) in sorted(pixels))
+
+
+# Returns the set of lit (y, x) pixels of an image.
+def image_pixels(img):
+  pixels = set()
+  for y in range(LED_SIDE_LEN):
+    for x in range(LED_SIDE_LEN):
+      if img.getpixel((x, y))[0] > SET_LED_THRESHOLD:
+        pixels.add((y, x))
+  return pixels
+
+
+# Returns the frames of a full-frame script as lists of (pixels, wait) per
+# sequence.
+def script_frames(source):
+  source = re.sub(r"//[^\n]*", "", source)
+  script = "".join(re.findall(r'"([^"]*)"', source))
+  sequences = []
+  for sequence in script.split("x"):
+    frames = re.findall(r"e0f((?:s[0-9a-f]{2})*)(w[0-9a-f]{4})e00a", sequence)
+    if "".join("e0f{}{}e00a".format(*f) for f in frames) != sequence:
+      sys.exit("not a script of full frames")
+    sequences.append([({(int(s[0], 16), int(s[1], 16)) for s in re.findall("s(..)", f[0])}, f[1])
+                      for f in frames])
+  return sequences
+
+
+# Returns the blit command of a frame: its 16 rows, column 0 the top bit.
+def blit_command(pixels):
+  rows = [0] * LED_SIDE_LEN
+  for (y, x) in pixels:
+    rows[y] |= 0x8000 >> x
+  return "b" + "".join("{:04x}".format(row) for row in rows)
+
+
+# Returns the script of one frame: everything lit in a keyframe, otherwise
+# only the pixels that changed since the previous frame.
+def frame_command(pixels, previous, keyframe):
+  if keyframe:
+    return "e00a" + set_leds_command("e0f", pixels)
+  return set_leds_command("e00", previous - pixels) + set_leds_command("e0f", pixels - previous)
+
+
 def main():
-  str_imgs = []
-  images = []
-  for name in IMAGE_NAMES:
-    try:
-      images.append(Image.open(name))
-    except IOError:
-      print("Couldn't open", name)
-  for img in images:
-    str_img = ""
-    for y in range(LED_SIDE_LEN):
-      for x in range(LED_SIDE_LEN):
-        if img.getpixel((x, y))[0] > SET_LED_THRESHOLD:
-          str_img += set_led_effect_command(x, y)
-    str_imgs.append(str_img)
-  
-  i = 0
-  for img in str_imgs:
-    i += 1
-    print("// {}:\n\"{}\"".format(i, img))
+  args = sys.argv[1:]
+  blit = "--blit" in args
+  if blit:
+    args.remove("--blit")
+  if len(args) == 2 and args[0] == "--script":
+    with open(args[1]) as f:
+      sequences = script_frames(f.read())
+  else:
+    from PIL import Image
+    frames = []
+    for name in IMAGE_NAMES:
+      try:
+        frames.append((image_pixels(Image.open(name)), wait_command(FRAME_WAIT_MS)))
+      except IOError:
+        print("Couldn't open", name)
+    sequences = [frames]
+
+  for n, frames in enumerate(sequences):
+    if n:
+      print("\n// Change animation.\n\"x\"\n")
+    previous = set()
+    for i, (pixels, wait) in enumerate(frames):
+      if blit:
+        command = blit_command(pixels)
+      else:
+        command = frame_command(pixels, previous, i % KEYFRAME_INTERVAL == 0)
+      print("// {}:\n\"{}\"\n\"{}\"".format(i + 1, command, wait))
+      previous = pixels
 
 
 main()
@@ -1,70 +1,82 @@
-#include <math.h> // for sin, cos
-// #include <stdint.h>
+#include <stdint.h>
+#include <avr/pgmspace.h>
 
 #define SCREEN_SIZE 16
 #define DIGIT_ROWS 5
 #define DIGIT_COLUMNS 3
-#define PI 3.14159265358979323846 // from math.h?
 #define MAX(X, Y) (((X) > (Y)) ? (X) : (Y))
 
 const uint16_t digits[10] = {31599, 9362, 29671, 29391, 23497, 31183, 31215, 29257, 31727, 31695};
 uint16_t screen[SCREEN_SIZE];
 uint16_t minutes = 12*60 + 34, seconds = 56;
 
-// Bresenham's line algorithm
-void drawLine(float x1, float y1, float x2, float y2)
+// Hand endpoints for the 60 positions of the hands, clockwise from 12, as
+// 0xYX pixel coordinates: floor(8 + length * sin(a)), floor(8 - length * cos(a))
+// clipped to the screen, the center of the face being the corner between
+// pixels 7 and 8.
+const uint8_t hand_short[60] PROGMEM = // length 4.5
 {
-    const bool steep = (fabs(y2 - y1) > fabs(x2 - x1));
-    float temp;
-    if(steep)
-    {
-        temp = x1;
-        x1 = y1;
-        y1 = temp;
-
-        temp = x2;
-        x2 = y2;
-        y2 = temp;
-    }
-    if(x1 > x2)
-    {
-        temp = x1;
-        x1 = x2;
-        x2 = temp;
-
-        temp = y1;
-        y1 = y2;
-        y2 = temp;
-    }
-
-    const float dx = x2 - x1;
-    const float dy = fabs(y2 - y1);
-
-    float error = dx / 2.0f;
-    const uint8_t ystep = (y1 < y2) ? 1 : -1;
-    uint8_t y = (uint8_t)y1;
+    0x38, 0x38, 0x38, 0x39, 0x39, 0x4a, 0x4a, 0x4b, 0x4b, 0x5b,
+    0x5b, 0x6c, 0x6c, 0x7c, 0x7c, 0x8c, 0x8c, 0x8c, 0x9c, 0x9c,
+    0xab, 0xab, 0xbb, 0xbb, 0xba, 0xba, 0xc9, 0xc9, 0xc8, 0xc8,
+    0xc8, 0xc7, 0xc7, 0xc6, 0xc6, 0xb5, 0xb5, 0xb4, 0xb4, 0xa4,
+    0xa4, 0x93, 0x93, 0x83, 0x83, 0x83, 0x73, 0x73, 0x63, 0x63,
+    0x54, 0x54, 0x44, 0x44, 0x45, 0x45, 0x36, 0x36, 0x37, 0x37,
+};
+const uint8_t hand_long[60] PROGMEM = // length 7.5
+{
+    0x08, 0x08, 0x09, 0x0a, 0x1b, 0x1b, 0x1c, 0x2d, 0x2d, 0x3e,
+    0x4e, 0x4e, 0x5f, 0x6f, 0x7f, 0x8f, 0x8f, 0x9f, 0xaf, 0xbe,
+    0xbe, 0xce, 0xdd, 0xdd, 0xec, 0xeb, 0xeb, 0xfa, 0xf9, 0xf8,
+    0xf8, 0xf7, 0xf6, 0xf5, 0xe4, 0xe4, 0xe3, 0xd2, 0xd2, 0xc1,
+    0xb1, 0xb1, 0xa0, 0x90, 0x80, 0x80, 0x70, 0x60, 0x50, 0x41,
+    0x41, 0x31, 0x22, 0x22, 0x13, 0x14, 0x14, 0x05, 0x06, 0x07,
+};
+
+// Lights pixel x, y, column 0 being the leftmost.
+void plot(uint8_t x, uint8_t y)
+{
+    screen[y] |= (1U << (SCREEN_SIZE - 1 - x));
+}
 
-    const uint8_t maxX = (uint8_t)x2;
+// Bresenham's line algorithm, both ends included
+void drawLine(int8_t x1, int8_t y1, int8_t x2, int8_t y2)
+{
+    const int8_t dx = (x2 > x1) ? x2 - x1 : x1 - x2;
+    const int8_t dy = (y2 > y1) ? y1 - y2 : y2 - y1; // negative
+    const int8_t xstep = (x1 < x2) ? 1 : -1;
+    const int8_t ystep = (y1 < y2) ? 1 : -1;
+    int8_t error = dx + dy;
 
-    for(uint8_t x=(uint8_t)x1; x<maxX; x++)
+    for(;;)
     {
-        if(steep)
-        {
-            screen[x] |= (1 << (SCREEN_SIZE - y));
-        }
-        else
+        plot(x1, y1);
+        if(x1 == x2 && y1 == y2)
+            break;
+        const int8_t error2 = 2 * error;
+        if(error2 >= dy)
         {
-            screen[y] |= (1 << (SCREEN_SIZE - x));
+            error += dy;
+            x1 += xstep;
         }
-        error -= dy;
-        if(error < 0)
+        if(error2 <= dx)
         {
-            y += ystep;
             error += dx;
+            y1 += ystep;
         }
     }
 }
 
+// Draws a hand from the center to the endpoint in hand[position].
+void drawHand(const uint8_t *hand, uint8_t position)
+{
+    const uint8_t end = pgm_read_byte(&hand[position]);
+    const int8_t x = end & 0x0f;
+    const int8_t y = end >> 4;
+    // Start from the center pixel on the side of the hand.
+    drawLine(x < 8 ? 7 : 8, y < 8 ? 7 : 8, x, y);
+}
+
 void displayDigitalClockOnScreen()
 {
     uint16_t hours;
@@ -96,32 +108,16 @@ void displayDigitalClockOnScreen()
 
 void displayAnalogClockOnScreen()
 {
-    uint16_t hours;
-    hours = minutes / 60;
-    minutes = minutes % 60;
-    
-    const float x0 = 8.25f;
-    const float y0 = 8.25f;
-
-    // Hours
-    float length = 5.f;
-    float angle = 2.5f * PI - (hours / 12.f * 2.f * PI);
-    float x1 = x0 + length * cos(angle);
-    float y1 = y0 - length * sin(angle);
-    drawLine(x0, y0, x1, y1);
+    const uint8_t hours = (minutes / 60) % 12;
+    const uint8_t mins = minutes % 60;
 
-    // Minutes
-    length = 8.f;
-    angle = 2.5f * PI - (minutes / 60.f * 2.f * PI);
-    x1 = x0 + length * cos(angle);
-    y1 = y0 - length * sin(angle);
-    drawLine(x0, y0, x1, y1);
+    for(uint8_t row=0;row<SCREEN_SIZE;row++)
+        screen[row] = 0;
 
-    // Seconds
-    angle = 2.5f * PI - (seconds / 60.f * 2.f * PI);
-    x1 = x0 + length * cos(angle);
-    y1 = y0 - length * sin(angle);
-    drawLine(x0, y0, x1, y1);
+    // The hour hand moves a position every 12 minutes.
+    drawHand(hand_short, hours * 5 + mins / 12);
+    drawHand(hand_long, mins);
+    drawHand(hand_long, seconds);
 }
 
 // #include <bitset>
@@ -53,21 +53,60 @@ PD0
 
 #include <math.h>
 
+#include "../pins.h" // generated from info/pins.txt
+
 #define ROWS 16
-#define ROW_WAIT_US 250
-// With 16-bit timer and 1/64 prescaler on F_CPU.
-#define USECS_PER_TIMER_OF 524288
+// Screen refreshes per second. Timer0 runs at F_CPU / 64 and interrupts once
+// per row, every 8 - 256 of its ticks: 31 - 976 Hz at 8 MHz. The 8 ticks
+// (512 cycles) a row leave the main loop time between the interrupts.
+#ifndef REFRESH_HZ
+#define REFRESH_HZ 250
+#endif
+#define ROW_TICKS (F_CPU / 64 / (REFRESH_HZ * ROWS))
+#if ROW_TICKS < 8 || ROW_TICKS > 256
+#error "REFRESH_HZ out of range"
+#endif
+// Timer1 ticks per second with 1/256 prescaler, exact at 8 MHz.
+#define TICKS_PER_SEC (F_CPU / 256)
 #define DEBOUNCE_TIME_MS 20
 
 #define SCREEN_SIZE 16
 #define DIGIT_ROWS 5
 #define DIGIT_COLUMNS 3
 #define PI 3.14159265358979323846 // from math.h?
+// Seconds ring pixels, the rest of the screen holds the digits.
+#define RING_COLUMNS 0x8001
 
-volatile uint16_t usecs, msecs, secs, mins;
+// The time as decimal digits, advanced by carries only: hours h10 h1,
+// minutes m10 m1 and seconds s10 s1.
+volatile uint8_t h10, h1, m10, m1, s10, s1;
+// Set by the timer interrupt every second, the screen is redrawn only then.
+volatile uint8_t second_changed;
 
 const uint16_t digits[10] = {31599, 25746, 29671, 29391, 23497, 31183, 31215, 29257, 31727, 31695};
 uint16_t screen[SCREEN_SIZE];
+// screen[] as port images, written as they are by the row interrupt. Anodes
+// are active low, the cathode bit of the row is set in its port. Two copies:
+// the interrupt shows one while screen_to_ports() fills the other.
+struct row_ports {
+	uint8_t port[PIN_PORTS]; // indexed by PIN_PORT_A - E
+};
+struct row_ports ports[2][ROWS];
+// The LED pins from pins.h as port number and bit mask.
+struct pin {
+	uint8_t port, mask;
+};
+#define PIN_OF(x, port, bit) {PIN_PORT_##port, 1 << (bit)},
+const struct pin anodes[ROWS] = {PINS_COLUMNS(PIN_OF,)};
+const struct pin cathodes[ROWS] = {PINS_ROWS(PIN_OF,)};
+// The bits of port (a PIN_PORT_ number) with an anode on them, high when idle.
+#define ANODE_BIT(port, p, bit) | ((PIN_PORT_##p == (port)) << (bit))
+#define ANODES_IDLE(port) (0 PINS_COLUMNS(ANODE_BIT, port))
+volatile uint8_t shown_ports;
+uint8_t scan_row;
+// What screen[] currently shows, the hours and minutes as packed digits.
+uint16_t shown_hm = 0xFFFF;
+uint8_t shown_secs;
 
 void setup();
 void tick_sleep();
@@ -76,11 +115,11 @@ void check_button();
 void clear_all();
 void clear_for_draw();
 void all_on();
-void set_row(uint8_t);
-void set_column(uint16_t);
-uint8_t firstDigit(uint8_t);
-uint8_t lastDigit(uint8_t);
+void screen_to_ports();
+void show_row(uint8_t);
+void blank_rows();
 void displayDigitalClockOnScreen();
+void ring_pixel(uint8_t);
 
 
 int main(void)
@@ -89,13 +128,13 @@ int main(void)
 	
 	while (1) {
 	
-		displayDigitalClockOnScreen();
-		for (uint8_t i = 0; i < ROWS; ++i) {
-			set_row(i);
-			set_column(screen[i]);
-			_delay_us(500);
-			clear_for_draw();
+		if (second_changed) {
+			second_changed = 0;
+			displayDigitalClockOnScreen();
+			screen_to_ports();
 		}
+		// The row and clock interrupts wake us up.
+		tick_sleep();
 	}
 }
 
@@ -111,97 +150,112 @@ void setup() {
 	DDRB |= 0x1F;
 	// Set pins LOW.
 	clear_all();
-	// Set 1/64 prescaler for Timer 1 for 125kHz frequency at 8Mhz.
-	TCCR1B |= (1 << CS10) | (1 << CS11);
-	// Reset timing numbers.
-	usecs = 0;
-	msecs = 0;
-	secs = 0;
-	mins = 0;
-	// Enable Timer1 overflow interrupt.
-	TIMSK |= (1 << TOIE1);
+	// Timer1 in CTC mode with 1/256 prescaler interrupts once a second.
+	OCR1A = TICKS_PER_SEC - 1;
+	TCCR1B = (1 << WGM12) | (1 << CS12);
+	// Reset the time.
+	h10 = h1 = m10 = m1 = s10 = s1 = 0;
+	second_changed = 1; // first draw
+	// Enable Timer1 compare interrupt.
+	TIMSK |= (1 << OCIE1A);
+	// Timer0 in CTC mode with 1/64 prescaler scans a row per compare match.
+	OCR0 = ROW_TICKS - 1;
+	TCCR0 = (1 << WGM01) | (1 << CS01) | (1 << CS00);
+	TIMSK |= (1 << OCIE0);
 	// Enable interrupts.
 	sei();
 }
 
-// Timed interrupt which increments the clock and checks for
-// button press.
-ISR(TIMER1_OVF_vect) {
-	usecs += 288;
-	msecs += 524 + usecs / 1000;
-	usecs %= 1000;
-	secs += msecs / 1000;
-	msecs %= 1000;
-	mins += secs / 60;
-	secs %= 60;
-	// One day of minutes.
-	mins %= 1440;
-}
-
-// Find the first digit of n
-uint8_t firstDigit(uint8_t n)
-{
-	while (n >= 10)
-		n /= 10;
-	return n;
+// Timed interrupt which advances the clock by a second.
+ISR(TIMER1_COMPA_vect) {
+	second_changed = 1;
+	if (++s1 < 10)
+		return;
+	s1 = 0;
+	if (++s10 < 6)
+		return;
+	s10 = 0;
+	if (++m1 < 10)
+		return;
+	m1 = 0;
+	if (++m10 < 6)
+		return;
+	m10 = 0;
+	if (++h1 == 4 && h10 == 2) {
+		// One day.
+		h1 = 0;
+		h10 = 0;
+	}
+	else if (h1 == 10) {
+		h1 = 0;
+		++h10;
+	}
 }
 
-// Find the last digit of n
-uint8_t lastDigit(uint8_t n)
-{
-	return (n % 10);
+// Shows the next row of the screen.
+ISR(TIMER0_COMP_vect) {
+	blank_rows();
+	if (++scan_row == ROWS)
+		scan_row = 0;
+	show_row(scan_row);
 }
 
+// Brings screen[] up to the current time: the digits when the minute has
+// changed, and the seconds ring by the pixels of the seconds since the last call.
 void displayDigitalClockOnScreen()
 {
-	uint8_t hours = mins / 60;
-	uint8_t minutes = mins % 60;
+	uint8_t hours10, hours1, minutes10, minutes1, now_secs;
+	cli();
+	hours10 = h10;
+	hours1 = h1;
+	minutes10 = m10;
+	minutes1 = m1;
+	now_secs = s10 * 10 + s1;
+	sei();
 
-	// Display hours and minutes
-	for(uint8_t row = 0; row < DIGIT_ROWS; ++row)
-	{
-		screen[row+2] = ((digits[firstDigit(hours)] >> ((DIGIT_ROWS - 1 - row) * DIGIT_COLUMNS)) & 7) << 9; // First digit of hours
-		screen[row+2] |= ((digits[lastDigit(hours)] >> ((DIGIT_ROWS - 1 - row) * DIGIT_COLUMNS)) & 7) << 4; // Second digit of hours
-		screen[row+9] = ((digits[firstDigit(minutes)] >> ((DIGIT_ROWS - 1 - row) * DIGIT_COLUMNS)) & 7) << 9; // First digit of minutes
-		screen[row+9] |= ((digits[lastDigit(minutes)] >> ((DIGIT_ROWS - 1 - row) * DIGIT_COLUMNS)) & 7) << 4; // Second digit of minutes
+	uint16_t now_hm = (hours10 << 12) | (hours1 << 8) | (minutes10 << 4) | minutes1;
+	if (now_hm != shown_hm) {
+		// Display hours and minutes, keeping the ring pixels on the same rows
+		for(uint8_t row = 0; row < DIGIT_ROWS; ++row)
+		{
+			uint8_t shift = (DIGIT_ROWS - 1 - row) * DIGIT_COLUMNS;
+			screen[row+2] &= RING_COLUMNS;
+			screen[row+2] |= ((digits[hours10] >> shift) & 7) << 9; // First digit of hours
+			screen[row+2] |= ((digits[hours1] >> shift) & 7) << 4; // Second digit of hours
+			screen[row+9] &= RING_COLUMNS;
+			screen[row+9] |= ((digits[minutes10] >> shift) & 7) << 9; // First digit of minutes
+			screen[row+9] |= ((digits[minutes1] >> shift) & 7) << 4; // Second digit of minutes
+		}
+		shown_hm = now_hm;
 	}
-	
-	// Display seconds as a ring around the screen
-	for(uint8_t s = 1; s <= secs; ++s)
-	{
-		if(s < 17)
-			screen[0] |= (1 << (16 - s));
-		else if(s < 32)
-			screen[s - 16] |= 1;
-		else if(s < 47)
-			screen[15] |= (1 << (s - 31));
-		else if(s < 61)
-			screen[61 - s] |= (1 << 15);
+
+	// Display seconds as a ring around the screen, a pixel per second. A new
+	// minute starts the ring over.
+	if (now_secs < shown_secs) {
+		screen[0] = 0;
+		screen[15] = 0;
+		for (uint8_t row = 1; row < 15; ++row)
+			screen[row] &= ~RING_COLUMNS;
+		shown_secs = 0;
 	}
+	while (shown_secs < now_secs)
+		ring_pixel(++shown_secs);
 }
 
-
-// Alternative to calculated version.
-void conditional_timer_add() {
-	usecs += 288;
-	msecs += 524;
-	if (usecs >= 1000) {
-		++msecs;
-		usecs %= 1000;
-	}
-	if (msecs >= 1000) {
-		++secs;
-		msecs %= 1000;
-	}
-	if (secs >= 60) {
-		++mins;
-		secs = 0;
-	}
-	if (mins >= 1440) {
-		mins = 0;
-	}
+// Lights the ring pixel of second s, 1 - 59.
+void ring_pixel(uint8_t s)
+{
+	if(s < 17)
+		screen[0] |= (1 << (16 - s));
+	else if(s < 32)
+		screen[s - 16] |= 1;
+	else if(s < 47)
+		screen[15] |= (1 << (s - 31));
+	else if(s < 61)
+		screen[61 - s] |= (1 << 15);
 }
 
+
 void tick_sleep() {
 	sleep_mode();
 }
@@ -234,10 +288,10 @@ void clear_all() {
 	// Cathodes.
 	PORTA &= ~0xF8;
 	PORTE &= ~0x07;
-	PORTC &= ~0xFF;
+	PORTC = 0x00;
 	// Anodes.
 	PORTA &= ~0x07;
-	PORTD &= ~0xFF;
+	PORTD = 0x00;
 	PORTB &= ~0x1F;
 }
 
@@ -251,7 +305,7 @@ void all_on() {
 	PORTC |= 0xFF;
 	// Anodes.
 	PORTA &= ~0x07;
-	PORTD &= ~0xFF;
+	PORTD = 0x00;
 	PORTB &= ~0x1F;
 }
 
@@ -259,42 +313,47 @@ void clear_for_draw() {
 	// Cathodes.
 	PORTA &= ~0xF8;
 	PORTE &= ~0x07;
-	PORTC &= ~0xFF;
+	PORTC = 0x00;
 	// Anodes.
 	PORTA |= 0x07;
 	PORTD |= 0xFF;
 	PORTB |= 0x1F;
 }
 
-// Takes number between 0-15 to activate certain row. Numbers over 15 are make
-// undefined behavior.
-void set_row(uint8_t row) {
-	if (row < 5) {
-		PORTA |= (1 << (row + PA3));
-	}
-	else if (row < 8) {
-		PORTE |= (1 << (row - PA5));
-	}
-	else {
-		PORTC |= (1 << (15 - row));
+// Converts screen[] into the ports[] copy not being shown and shows it. A
+// screen row has bit 15 leftmost.
+void screen_to_ports() {
+	uint8_t next = shown_ports ^ 1;
+	for (uint8_t row = 0; row < ROWS; ++row) {
+		uint16_t col = screen[row];
+		uint8_t *p = ports[next][row].port;
+		for (uint8_t port = 0; port < PIN_PORTS; ++port) {
+			p[port] = ANODES_IDLE(port);
+		}
+		for (uint8_t x = 0; x < ROWS; ++x) {
+			if (col & (0x8000 >> x)) {
+				p[anodes[x].port] &= ~anodes[x].mask;
+			}
+		}
+		// Cathode of the row.
+		p[cathodes[row].port] |= cathodes[row].mask;
 	}
+	shown_ports = next;
 }
 
+// Lights row from its port images, the rows must be blank.
+void show_row(uint8_t row) {
+	const struct row_ports *p = &ports[shown_ports][row];
+	PORTB = p->port[PIN_PORT_B];
+	PORTD = p->port[PIN_PORT_D];
+	PORTA = p->port[PIN_PORT_A];
+	PORTC = p->port[PIN_PORT_C];
+	PORTE = p->port[PIN_PORT_E];
+}
 
-void set_column(uint16_t col) {
-	for (int16_t i = 7; i >= 0; --i) {
-		if (col & (1 << (2 * i))) {
-			PORTD &= ~(1 << i);
-		}
-	}
-	for (int16_t i = 2; i >= 0; --i) {
-		if (col & (1 << (11 + 2*i))) {
-			PORTA &= ~(1 << i);
-		}
-	}
-	for (int16_t i = 0; i < 5; ++i) {
-		if (col & (1 << (9 - 2*i))) {
-			PORTB &= ~(1 << i);
-		}
-	} 
+// Turns the lit row off: all cathodes low.
+void blank_rows() {
+	PORTA = ANODES_IDLE(PIN_PORT_A);
+	PORTC = ANODES_IDLE(PIN_PORT_C);
+	PORTE = ANODES_IDLE(PIN_PORT_E);
 }
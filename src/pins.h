@@ -0,0 +1,48 @@
+// Generated from info/pins.txt by pins_to_code.py, do not edit.
+
+#ifndef PINS_H
+#define PINS_H
+
+// The LED matrix pins as X macros: F(x, port letter, bit) for every pin, x
+// passed through. Cathodes (rows) top to bottom, they light a row when high.
+#define PINS_ROWS(F,x) \
+  F(x,A,3) F(x,A,4) F(x,A,5) F(x,A,6) F(x,A,7) F(x,E,0) F(x,E,1) F(x,E,2) \
+  F(x,C,7) F(x,C,6) F(x,C,5) F(x,C,4) F(x,C,3) F(x,C,2) F(x,C,1) F(x,C,0)
+// Anodes (columns) left to right, they light a column when low.
+#define PINS_COLUMNS(F,x) \
+  F(x,A,2) F(x,D,7) F(x,A,1) F(x,D,6) F(x,A,0) F(x,D,5) F(x,B,0) F(x,D,4) \
+  F(x,B,1) F(x,D,3) F(x,B,2) F(x,D,2) F(x,B,3) F(x,D,1) F(x,B,4) F(x,D,0)
+// Single columns, for tables that pair them up.
+#define PINS_COLUMN_0(F,x) F(x,A,2)
+#define PINS_COLUMN_1(F,x) F(x,D,7)
+#define PINS_COLUMN_2(F,x) F(x,A,1)
+#define PINS_COLUMN_3(F,x) F(x,D,6)
+#define PINS_COLUMN_4(F,x) F(x,A,0)
+#define PINS_COLUMN_5(F,x) F(x,D,5)
+#define PINS_COLUMN_6(F,x) F(x,B,0)
+#define PINS_COLUMN_7(F,x) F(x,D,4)
+#define PINS_COLUMN_8(F,x) F(x,B,1)
+#define PINS_COLUMN_9(F,x) F(x,D,3)
+#define PINS_COLUMN_10(F,x) F(x,B,2)
+#define PINS_COLUMN_11(F,x) F(x,D,2)
+#define PINS_COLUMN_12(F,x) F(x,B,3)
+#define PINS_COLUMN_13(F,x) F(x,D,1)
+#define PINS_COLUMN_14(F,x) F(x,B,4)
+#define PINS_COLUMN_15(F,x) F(x,D,0)
+
+// Port numbers, for indexing and comparing the port letters.
+#define PIN_PORT_A 0
+#define PIN_PORT_B 1
+#define PIN_PORT_C 2
+#define PIN_PORT_D 3
+#define PIN_PORT_E 4
+#define PIN_PORTS  5
+
+// Bit of the little endian l_port word (ref/led.c) a column pin drives:
+// A2 - A0 in bits 7 - 5, B4 - B0 in 4 - 0, D7 - D0 in 15 - 8.
+#define PIN_WORD_BIT(x,port,bit) PIN_WORD_BIT_##port(bit)
+#define PIN_WORD_BIT_A(bit) ((bit)+5)
+#define PIN_WORD_BIT_B(bit) (bit)
+#define PIN_WORD_BIT_D(bit) ((bit)+8)
+
+#endif
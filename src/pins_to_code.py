@@ -0,0 +1,120 @@
+import os
+import re
+import sys
+
+# Turns the LED matrix pin list info/pins.txt into pins.h: X macros of the
+# cathode (row) and anode (column) pins that the firmware builds its port
+# masks and column order from at compile time.
+# Usage: python3 pins_to_code.py [PINS [OUTPUT]]
+
+ROWS = 16
+PINS = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "info", "pins.txt")
+
+# Pins the scan code can drive: the row cathodes anywhere on PORTA 3 - 7, C
+# and E, the column anodes where l_port (ref/led.c) packs them.
+ROW_PINS = {"A": range(3, 8), "C": range(8), "E": range(3)}
+COLUMN_PINS = {"A": range(3), "B": range(5), "D": range(8)}
+
+
+class PinError(Exception):
+  pass
+
+
+# Returns the rows top to bottom and the columns left to right as lists of
+# (port letter, bit).
+def read_pins(text):
+  sections = {}
+  section = None
+  for line in text.splitlines():
+    line = line.strip()
+    if line.startswith("Katodit"):
+      section = sections.setdefault("rows", [])
+    elif line.startswith("Anodit"):
+      section = sections.setdefault("columns", [])
+    elif line:
+      m = re.fullmatch(r"P([A-E])([0-7])", line)
+      if not m or section is None:
+        raise PinError("bad line '{}'".format(line))
+      section.append((m.group(1), int(m.group(2))))
+  rows = sections.get("rows", [])
+  columns = sections.get("columns", [])
+  if len(rows) != ROWS or len(columns) != ROWS:
+    raise PinError("{} rows and {} columns, need {} of each".format(len(rows), len(columns), ROWS))
+  if len(set(rows + columns)) != 2 * ROWS:
+    raise PinError("a pin is used twice")
+  for port, bit in rows:
+    if bit not in ROW_PINS.get(port, ()):
+      raise PinError("P{}{} cannot be a row".format(port, bit))
+  for x, (port, bit) in enumerate(columns):
+    if bit not in COLUMN_PINS.get(port, ()):
+      raise PinError("P{}{} cannot be a column".format(port, bit))
+    # l2led() packs even columns into the A/B byte and odd ones into D
+    if (port == "D") != (x % 2 == 1):
+      raise PinError("column {} on P{}{}: even columns go to A or B, odd to D".format(x, port, bit))
+  return rows, columns
+
+
+# Returns the bit of l_port's little endian word that column pin port, bit
+# drives: A2 - A0 in bits 7 - 5, B4 - B0 in 4 - 0, D7 - D0 in 15 - 8.
+def word_bit(port, bit):
+  return {"A": bit + 5, "B": bit, "D": bit + 8}[port]
+
+
+def to_c(rows, columns, name):
+  def pins(list_):
+    return " \\\n  ".join(" ".join("F(x,{},{})".format(*pin) for pin in list_[i:i + 8])
+                          for i in range(0, len(list_), 8))
+  lines = ["// Generated from {} by pins_to_code.py, do not edit.".format(name),
+           "",
+           "#ifndef PINS_H",
+           "#define PINS_H",
+           "",
+           "// The LED matrix pins as X macros: F(x, port letter, bit) for every pin, x",
+           "// passed through. Cathodes (rows) top to bottom, they light a row when high.",
+           "#define PINS_ROWS(F,x) \\\n  " + pins(rows),
+           "// Anodes (columns) left to right, they light a column when low.",
+           "#define PINS_COLUMNS(F,x) \\\n  " + pins(columns),
+           "// Single columns, for tables that pair them up.",
+           ]
+  for x, pin in enumerate(columns):
+    lines.append("#define PINS_COLUMN_{}(F,x) F(x,{},{})".format(x, *pin))
+  lines += ["",
+            "// Port numbers, for indexing and comparing the port letters.",
+            "#define PIN_PORT_A 0",
+            "#define PIN_PORT_B 1",
+            "#define PIN_PORT_C 2",
+            "#define PIN_PORT_D 3",
+            "#define PIN_PORT_E 4",
+            "#define PIN_PORTS  5",
+            "",
+            "// Bit of the little endian l_port word (ref/led.c) a column pin drives:",
+            "// A2 - A0 in bits 7 - 5, B4 - B0 in 4 - 0, D7 - D0 in 15 - 8.",
+            "#define PIN_WORD_BIT(x,port,bit) PIN_WORD_BIT_##port(bit)",
+            "#define PIN_WORD_BIT_A(bit) ((bit)+5)",
+            "#define PIN_WORD_BIT_B(bit) (bit)",
+            "#define PIN_WORD_BIT_D(bit) ((bit)+8)",
+            "",
+            "#endif"]
+  return "\n".join(lines) + "\n"
+
+
+def main():
+  args = sys.argv[1:]
+  if len(args) > 2:
+    sys.exit("usage: pins_to_code.py [PINS [OUTPUT]]")
+  path = args[0] if args else PINS
+  with open(path) as f:
+    try:
+      rows, columns = read_pins(f.read())
+    except PinError as e:
+      sys.exit("{}: {}".format(path, e))
+  text = to_c(rows, columns, "info/pins.txt")
+  if len(args) == 2:
+    with open(args[1], "w") as f:
+      f.write(text)
+  else:
+    sys.stdout.write(text)
+
+
+if __name__ == "__main__":
+  main()
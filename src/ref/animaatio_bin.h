@@ -0,0 +1,35 @@
+// Generated by script_to_code.py from animaatio.h, do not edit.
+0x02,0x0f,0x0d,0x55,0x5a,0x07,0x0d,0x00,0x02,0x00,0x05,0x02,0x0f,0x04,0x05,0x55,
+0x56,0x57,0x68,0x69,0x07,0x0d,0x00,0x02,0x00,0x05,0x02,0x0f,0x04,0x05,0x55,0x56,
+0x67,0x68,0x79,0x07,0x0d,0x00,0x02,0x00,0x05,0x02,0x0f,0x04,0x04,0x55,0x66,0x67,
+0x78,0x07,0x0d,0x00,0x02,0x00,0x05,0x02,0x0f,0x04,0x04,0x55,0x66,0x77,0x88,0x07,
+0x0d,0x00,0x02,0x00,0x05,0x02,0x0f,0x04,0x04,0x55,0x66,0x76,0x87,0x07,0x0d,0x00,
+0x02,0x00,0x05,0x02,0x0f,0x04,0x05,0x55,0x65,0x76,0x86,0x97,0x07,0x0d,0x00,0x02,
+0x00,0x05,0x02,0x0f,0x04,0x05,0x55,0x65,0x75,0x86,0x96,0x07,0x0d,0x00,0x02,0x00,
+0x05,0x02,0x0f,0x0d,0x55,0xa5,0x07,0x0d,0x00,0x02,0x00,0x05,0x02,0x0f,0x0d,0x55,
+0xa5,0x07,0x0d,0x00,0x02,0x00,0x05,0x02,0x0f,0x04,0x05,0x66,0x76,0x85,0x95,0xa5,
+0x07,0x0d,0x00,0x02,0x00,0x05,0x02,0x0f,0x04,0x05,0x67,0x76,0x86,0x95,0xa5,0x07,
+0x0d,0x00,0x02,0x00,0x05,0x02,0x0f,0x04,0x04,0x77,0x86,0x96,0xa5,0x07,0x0d,0x00,
+0x02,0x00,0x05,0x02,0x0f,0x04,0x04,0x78,0x87,0x96,0xa5,0x07,0x0d,0x00,0x02,0x00,
+0x05,0x02,0x0f,0x04,0x04,0x88,0x96,0x97,0xa5,0x07,0x0d,0x00,0x02,0x00,0x05,0x02,
+0x0f,0x04,0x05,0x89,0x97,0x98,0xa5,0xa6,0x07,0x0d,0x00,0x02,0x00,0x05,0x02,0x0f,
+0x04,0x05,0x98,0x99,0xa5,0xa6,0xa7,0x07,0x0d,0x00,0x02,0x00,0x05,0x02,0x0f,0x0d,
+0xa5,0xaa,0x07,0x0d,0x00,0x02,0x00,0x05,0x02,0x0f,0x0d,0xa5,0xaa,0x07,0x0d,0x00,
+0x02,0x00,0x05,0x02,0x0f,0x04,0x05,0x96,0x97,0xa8,0xa9,0xaa,0x07,0x0d,0x00,0x02,
+0x00,0x05,0x02,0x0f,0x04,0x05,0x86,0x97,0x98,0xa9,0xaa,0x07,0x0d,0x00,0x02,0x00,
+0x05,0x02,0x0f,0x04,0x04,0x87,0x98,0x99,0xaa,0x07,0x0d,0x00,0x02,0x00,0x05,0x02,
+0x0f,0x04,0x04,0x77,0x88,0x99,0xaa,0x07,0x0d,0x00,0x02,0x00,0x05,0x02,0x0f,0x04,
+0x04,0x78,0x89,0x99,0xaa,0x07,0x0d,0x00,0x02,0x00,0x05,0x02,0x0f,0x04,0x05,0x68,
+0x79,0x89,0x9a,0xaa,0x07,0x0d,0x00,0x02,0x00,0x05,0x02,0x0f,0x04,0x05,0x69,0x79,
+0x8a,0x9a,0xaa,0x07,0x0d,0x00,0x02,0x00,0x05,0x02,0x0f,0x0d,0x5a,0xaa,0x07,0x0d,
+0x00,0x02,0x00,0x05,0x02,0x0f,0x0d,0x5a,0xaa,0x07,0x0d,0x00,0x02,0x00,0x05,0x02,
+0x0f,0x04,0x05,0x5a,0x6a,0x7a,0x89,0x99,0x07,0x0d,0x00,0x02,0x00,0x05,0x02,0x0f,
+0x04,0x05,0x5a,0x6a,0x79,0x89,0x98,0x07,0x0d,0x00,0x02,0x00,0x05,0x02,0x0f,0x04,
+0x04,0x5a,0x69,0x79,0x88,0x07,0x0d,0x00,0x02,0x00,0x05,0x02,0x0f,0x04,0x04,0x5a,
+0x69,0x78,0x87,0x07,0x0d,0x00,0x02,0x00,0x05,0x02,0x0f,0x04,0x04,0x5a,0x68,0x69,
+0x77,0x07,0x0d,0x00,0x02,0x00,0x05,0x02,0x0f,0x04,0x05,0x59,0x5a,0x67,0x68,0x76,
+0x07,0x0d,0x00,0x02,0x00,0x05,0x02,0x0f,0x04,0x05,0x58,0x59,0x5a,0x66,0x67,0x07,
+0x0d,0x00,0x02,0x00,0x05,0x02,0x0f,0x0d,0x55,0x5a,0x07,0x0d,0x00,0x02,0x00,0x05,
+0x00,
+#define ANIMATION_SEQUENCES 1
+#define ANIMATION_START 0x0000
@@ -1,6 +1,12 @@
 #include <avr/pgmspace.h> 
 
-const char animation[] PROGMEM= 
-#include "animaatio.h"
-"\0\0";
+#include "led.h"
 
+// compiled from animaatio.h with script_to_code.py, animation.cpp does the same at build time
+const uint8_t animation[] PROGMEM={
+#include "animaatio_bin.h"
+};
+
+// where each sequence starts in animation[], setanimation() jumps straight there
+const uint16_t animation_start[] PROGMEM={ANIMATION_START};
+const uint8_t animation_sequences=ANIMATION_SEQUENCES;
@@ -0,0 +1,20 @@
+// The animation compiled at build time by script.hpp, in place of animation.c
+// and script_to_code.py. Link one of the two.
+
+#include <avr/pgmspace.h>
+
+#include "script.hpp"
+
+static constexpr char animation_script[] =
+#include "animaatio.h"
+    ;
+
+static constexpr script::Counter ANIMATION = script::count(animation_script);
+
+extern "C" const script::Image<ANIMATION.size> animation PROGMEM =
+    script::image<ANIMATION.size, ANIMATION.sequences>(animation_script);
+
+// where each sequence starts in animation[], setanimation() jumps straight there
+extern "C" const script::Starts<ANIMATION.sequences> animation_start PROGMEM =
+    script::starts<ANIMATION.size, ANIMATION.sequences>(animation_script);
+extern "C" const uint8_t animation_sequences = ANIMATION.sequences;
@@ -0,0 +1,105 @@
+#include <avr/pgmspace.h>
+
+#include <string.h>
+
+#include "led.h"
+#include "face.h"
+
+#define FACE_CENTER (8*FACE_PX) // the corner between leds 7 and 8
+
+// sin of the 60 positions of a hand clockwise from 12, *127
+const int8_t face_sin[60] PROGMEM={
+  0,13,26,39,52,63,75,85,94,103,110,116,121,124,126,
+  127,126,124,121,116,110,103,94,85,75,63,52,39,26,13,
+  0,-13,-26,-39,-52,-63,-75,-85,-94,-103,-110,-116,-121,-124,-126,
+  -127,-126,-124,-121,-116,-110,-103,-94,-85,-75,-63,-52,-39,-26,-13};
+
+void face_plot(int8_t x, int8_t y, uint8_t value);
+void face_hand(uint8_t position, uint8_t from, uint8_t to, uint8_t level);
+
+
+
+// lights led x, y at least to value, off-screen leds are skipped
+void face_plot(int8_t x, int8_t y, uint8_t value)
+{
+uint8_t *p;
+if (((uint8_t)x>=ROWS) || ((uint8_t)y>=ROWS)) return;
+p=&l[(y<<4)+x];
+if (value>*p)
+   {
+   *p=value;
+   l_dirty|=(uint16_t)1<<y;
+   }
+}
+
+
+
+// Wu line at brightness level 0 - 15: every led column (row for a steep line)
+// between the ends gets two leds, shared by how near their centers the line
+// passes. Fixed point, one division per line. Leds already brighter stay so,
+// overlapping lines do not darken each other.
+void face_line(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t level)
+{
+int16_t t,dx,dy,grad,y;
+int8_t x,end,row;
+uint8_t steep,f;
+
+steep=((y1>y0) ? y1-y0 : y0-y1)>((x1>x0) ? x1-x0 : x0-x1);
+if (steep)
+   {
+   t=x0; x0=y0; y0=t;
+   t=x1; x1=y1; y1=t;
+   }
+if (x0>x1)
+   {
+   t=x0; x0=x1; x1=t;
+   t=y0; y0=y1; y1=t;
+   }
+dx=x1-x0;
+dy=y1-y0;
+if (dx==0) return;
+grad=((int32_t)dy<<8)/dx; // y step per led in 1/256 led
+x=(x0-FACE_PX/2+FACE_PX-1)>>4; // first led center at or after x0
+end=(x1-FACE_PX/2)>>4;
+// y in 1/256 led at the center of led x, from the center of the led above
+y=(y0<<4)+(((x<<4)+FACE_PX/2-x0)*grad>>4)-128;
+for (;x<=end;x++,y+=grad)
+   {
+   row=y>>8;
+   f=(y>>4)&0x0f; // share of the led below
+   if (steep)
+      {
+	  face_plot(row,x,(level*(16-f))>>4);
+	  face_plot(row+1,x,(level*f)>>4);
+	  }
+   else
+      {
+	  face_plot(x,row,(level*(16-f))>>4);
+	  face_plot(x,row+1,(level*f)>>4);
+	  }
+   }
+}
+
+
+
+// draws a line at position 0 - 59 from radius from to radius to (1/16 led)
+void face_hand(uint8_t position, uint8_t from, uint8_t to, uint8_t level)
+{
+int16_t sn=(int8_t)pgm_read_byte_near(&face_sin[position]);
+int16_t cs=(int8_t)pgm_read_byte_near(&face_sin[(position<45) ? position+15 : position-45]);
+face_line(FACE_CENTER+((from*sn+64)>>7),FACE_CENTER-((from*cs+64)>>7),
+   FACE_CENTER+((to*sn+64)>>7),FACE_CENTER-((to*cs+64)>>7),level);
+}
+
+
+
+// replaces l[] with an analog clock at h:m:s, l2led() shows it
+void face_draw(uint8_t h, uint8_t m, uint8_t s)
+{
+memset(l,0,ROWS*ROWS);
+l_dirty=0xffff;
+for (uint8_t i=0;i<60;i+=5) face_hand(i,6*FACE_PX,8*FACE_PX,(i%15) ? 3 : 7); // hour marks
+face_hand(s,0,7*FACE_PX,5);
+face_hand(m,0,FACE_PX*13/2,15);
+face_hand((h%12)*5+m/12,0,FACE_PX*9/2,15);
+}
@@ -0,0 +1,19 @@
+// Anti-aliased drawing into l[] (led.c): Xiaolin Wu lines in 1/16 pixel
+// coordinates and an analog clock face built on them.
+// No firmware mode calls face_draw() yet, only the simulator (simulate -c,
+// bench_animate). A redraw costs about 1 us on the host; by a hand count,
+// not verified, 10000 - 15000 cycles (1.3 - 1.9 ms at 8 MHz) on the AVR,
+// most of it the 32-bit division of each of the 15 lines.
+
+#ifndef FACE_H
+#define FACE_H
+
+#include <stdint.h>
+
+// coordinates in 1/16 pixel, the center of led x, y is at 16*x+8, 16*y+8
+#define FACE_PX 16
+
+void face_line(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t level);
+void face_draw(uint8_t h, uint8_t m, uint8_t s);
+
+#endif
@@ -1,6 +1,10 @@
 
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+#include <stddef.h>
+#include <string.h>
 
 #include "led.h"
 
@@ -8,46 +12,132 @@
 uint8_t  l[ROWS*ROWS]; // analog brightness values 0 - 15
 
 // first A2 A1 A0 B4 B3 B2 B1 B0 second: D7 D6 D5 D4 D3 D2 D1 D0
-uint8_t  l_port[ROWS][4][2]; // actually there are 3 ports (A, B and D) to update, but this packs and aligns the data
+// actually there are 3 ports (A, B and D) to update, but this packs and aligns the data
+// two frames: the interrupt scans one while l2led() writes the other (l_port), they
+// change places at the start of a scan after l_swap is set
+uint8_t  l_buffer[2][ROWS][LED_PLANES][2];
+uint8_t  (*volatile l_port)[LED_PLANES][2]=l_buffer[0];
+uint8_t  (*volatile l_scan)[LED_PLANES][2]=l_buffer[1];
+volatile uint8_t l_swap;
+uint16_t l_stale; // rows l_scan lacks compared to l_port, they get repacked after the swap
+uint16_t l_dirty; // rows of l[] changed since the last l2led(), bit n = row n
+uint16_t l_lit;   // rows of l_port with a lit led, bit n = row n
+// the lit rows of the two frames, they change places with l_port and l_scan
+struct lit_rows l_lit_rows[2];
+struct lit_rows *volatile l_port_lit=&l_lit_rows[0];
+struct lit_rows *volatile l_scan_lit=&l_lit_rows[1];
 
 volatile uint8_t led_row=0,led_phase=0,led_button=0;
 volatile uint8_t led_tick=0;
-
-uint8_t l_order[16]={1,3,5,7,9,11,13,15,0,2,4,14,12,10,8,6,};
-
-struct line X[ROWS]={{0,7},
-				     {1,7},
-				     {0,6},
-				     {1,6},
-				     {0,5},
-				     {1,5},
-				     {0,0},
-				     {1,4},
-				     {0,1},
-				     {1,3},
-				     {0,2},
-				     {1,2},
-				     {0,3},
-				     {1,1},
-				     {0,4},
-				     {1,0}};
-
-struct line Y[ROWS]={{(uint16_t)&PORTA,3},
-					 {(uint16_t)&PORTA,4},
-					 {(uint16_t)&PORTA,5},
-					 {(uint16_t)&PORTA,6},
-					 {(uint16_t)&PORTA,7},
-					 {(uint16_t)&PORTE,0},
-					 {(uint16_t)&PORTE,1},
-					 {(uint16_t)&PORTE,2},
-					 {(uint16_t)&PORTC,7},
-					 {(uint16_t)&PORTC,6},
-					 {(uint16_t)&PORTC,5},
-					 {(uint16_t)&PORTC,4},
-					 {(uint16_t)&PORTC,3},
-					 {(uint16_t)&PORTC,2},
-					 {(uint16_t)&PORTC,1},
-					 {(uint16_t)&PORTC,0}};
+uint8_t  led_time; // row times scanned towards the next led_tick, a tick is 16
+uint8_t  *led_next; // entry of l_scan_lit->row lit by the next interrupt
+uint16_t led_period[LED_PHASES]; // OCR1A for each phase, with LED_COMPENSATE the dark one last
+
+
+// the pins of info/pins.txt, see pins.h
+#define X_LINE(x,p,b)    {PIN_WORD_BIT(x,p,b)>>3,PIN_WORD_BIT(x,p,b)&7},
+#define Y_BIT(p,q,b)     ((PIN_PORT_##p==PIN_PORT_##q)<<(b)) // 1<<b if the pin is on port q
+#define Y_CATHODE(x,p,b) {Y_BIT(p,C,b),Y_BIT(p,E,b),Y_BIT(p,A,b),0},
+#define COLUMN_BIT(n)    (PINS_COLUMN_##n(PIN_WORD_BIT,)&7) // of the column's l_port byte
+
+// in flash, as SRAM is short with 8 planes
+const struct line X[ROWS] PROGMEM={PINS_COLUMNS(X_LINE,)};
+
+const struct cathode Y[ROWS] PROGMEM={PINS_ROWS(Y_CATHODE,)};
+
+// bitplane level of a brightness value 0 - 15
+#if LED_PLANES==4
+#define L_LEVEL(v) (v)
+#else
+#define L_LEVEL(v) ((v) ? ((uint16_t)(v)*(v)*((1<<LED_PLANES)-1)+224)/225 : 0)
+#endif
+
+// l2led() builds the byte of a bitplane by shifting in that plane's bit of every
+// column's level, highest port bit first: 2 cycles a bit on AVR (lsr, rol), about
+// 13 a pixel with the stores at 4 planes against 29 of the old shift loop (hand
+// count, no avr-gcc measurement, short of the 3x asked for). COLUMN_AT(w) is the
+// column on bit w of the l_port word, even columns in byte 0 (A/B) and odd in 1 (D),
+// pins_to_code.py checks pins.txt keeps it so.
+#define CW(c,w) ((PINS_COLUMN_##c(PIN_WORD_BIT,)==(w))*(c))
+#define COLUMN_AT(w) (CW(0,w)+CW(1,w)+CW(2,w)+CW(3,w)+CW(4,w)+CW(5,w)+CW(6,w)+CW(7,w)+ \
+                      CW(8,w)+CW(9,w)+CW(10,w)+CW(11,w)+CW(12,w)+CW(13,w)+CW(14,w)+CW(15,w))
+
+#if LED_PLANES>4
+const uint8_t l_level[16] PROGMEM={L_LEVEL(0),L_LEVEL(1),L_LEVEL(2),L_LEVEL(3),L_LEVEL(4),L_LEVEL(5),
+                                   L_LEVEL(6),L_LEVEL(7),L_LEVEL(8),L_LEVEL(9),L_LEVEL(10),L_LEVEL(11),
+                                   L_LEVEL(12),L_LEVEL(13),L_LEVEL(14),L_LEVEL(15)};
+#endif
+
+// the planes of a row as named asm operands and the stores of l2led(), ports are
+// active low
+#define L_SHIFT(q) "lsr %[v]\n\t" "rol %[p" #q "]\n\t"
+#define L_OUT(q,planes) [p##q] "=&r" ((planes)[q])
+#define L_STORE(q) lit|=ab[q]|d[q]; port[j][q][0]=~ab[q]; port[j][q][1]=~d[q];
+#define L_PLANES4(f) f(0) f(1) f(2) f(3)
+#if LED_PLANES==4
+#define L_SHIFTS L_PLANES4(L_SHIFT)
+#define L_OUTS(p) L_OUT(0,p),L_OUT(1,p),L_OUT(2,p),L_OUT(3,p)
+#define L_STORES L_PLANES4(L_STORE)
+#elif LED_PLANES==6
+#define L_SHIFTS L_PLANES4(L_SHIFT) L_SHIFT(4) L_SHIFT(5)
+#define L_OUTS(p) L_OUT(0,p),L_OUT(1,p),L_OUT(2,p),L_OUT(3,p),L_OUT(4,p),L_OUT(5,p)
+#define L_STORES L_PLANES4(L_STORE) L_STORE(4) L_STORE(5)
+#else
+#define L_SHIFTS L_PLANES4(L_SHIFT) L_SHIFT(4) L_SHIFT(5) L_SHIFT(6) L_SHIFT(7)
+#define L_OUTS(p) L_OUT(0,p),L_OUT(1,p),L_OUT(2,p),L_OUT(3,p),L_OUT(4,p),L_OUT(5,p),L_OUT(6,p),L_OUT(7,p)
+#define L_STORES L_PLANES4(L_STORE) L_STORE(4) L_STORE(5) L_STORE(6) L_STORE(7)
+#endif
+
+#ifdef SIM
+// portable version of the asm below, keep the two in step
+static const uint8_t l_column[16]={COLUMN_AT(0),COLUMN_AT(1),COLUMN_AT(2),COLUMN_AT(3),
+                                   COLUMN_AT(4),COLUMN_AT(5),COLUMN_AT(6),COLUMN_AT(7),
+                                   COLUMN_AT(8),COLUMN_AT(9),COLUMN_AT(10),COLUMN_AT(11),
+                                   COLUMN_AT(12),COLUMN_AT(13),COLUMN_AT(14),COLUMN_AT(15)};
+#define L_PACK(n,row,p) do { \
+   memset((p),0,LED_PLANES); \
+   for (uint8_t w=8*(n)+8;w-->8*(n);) \
+      { \
+	  v=(row)[l_column[w]]; \
+	  for (uint8_t q=0;q<LED_PLANES;q++,v>>=1) (p)[q]=(uint8_t)((p)[q]<<1)|(v&1); \
+	  } \
+   } while (0)
+#else
+// port byte n (0 A/B, 1 D) of row's levels into the planes p
+#define L_BIT(k) "ldd %[v],%a[row]+%[c" #k "]\n\t" L_SHIFTS
+#define L_PACK(n,row,p) \
+   asm volatile ( \
+   L_BIT(7) L_BIT(6) L_BIT(5) L_BIT(4) L_BIT(3) L_BIT(2) L_BIT(1) L_BIT(0) \
+   :L_OUTS(p),[v] "=&r" (v) \
+   :[row] "b" (row), \
+   [c7] "I" (COLUMN_AT(8*(n)+7)),[c6] "I" (COLUMN_AT(8*(n)+6)), \
+   [c5] "I" (COLUMN_AT(8*(n)+5)),[c4] "I" (COLUMN_AT(8*(n)+4)), \
+   [c3] "I" (COLUMN_AT(8*(n)+3)),[c2] "I" (COLUMN_AT(8*(n)+2)), \
+   [c1] "I" (COLUMN_AT(8*(n)+1)),[c0] "I" (COLUMN_AT(8*(n))) \
+   :"memory")
+#endif
+
+
+// l_scroll() lookup: a column step swaps the two bytes of a row and moves the bits
+// to the other byte's order. Going left, odd column 2k+1 becomes even column 2k
+// (l_mirror) and even 2k+2 becomes odd 2k+1, column 0 wrapping to 15 (l_left).
+// Going right the other way round, l_right wraps column 15 to 0.
+// l_mirror serves both ways, the check below makes sure it is its own inverse.
+#define MV(v,from,to) (((v)>>COLUMN_BIT(from)&1)<<COLUMN_BIT(to))
+#define MIRROR(v) (MV(v,1,0)|MV(v,3,2)|MV(v,5,4)|MV(v,7,6)|MV(v,9,8)|MV(v,11,10)|MV(v,13,12)|MV(v,15,14))
+#define LEFT(v)   (MV(v,2,1)|MV(v,4,3)|MV(v,6,5)|MV(v,8,7)|MV(v,10,9)|MV(v,12,11)|MV(v,14,13)|MV(v,0,15))
+#define RIGHT(v)  (MV(v,15,0)|MV(v,1,2)|MV(v,3,4)|MV(v,5,6)|MV(v,7,8)|MV(v,9,10)|MV(v,11,12)|MV(v,13,14))
+#define T4(f,n)   f(n),f((n)+1),f((n)+2),f((n)+3)
+#define T16(f,n)  T4(f,n),T4(f,(n)+4),T4(f,(n)+8),T4(f,(n)+12)
+#define T64(f,n)  T16(f,n),T16(f,(n)+16),T16(f,(n)+32),T16(f,(n)+48)
+#define T256(f)   {T64(f,0),T64(f,64),T64(f,128),T64(f,192)}
+
+const uint8_t l_mirror[256] PROGMEM=T256(MIRROR);
+const uint8_t l_left[256] PROGMEM=T256(LEFT);
+const uint8_t l_right[256] PROGMEM=T256(RIGHT);
+#define MIRRORED(v) (MIRROR(MIRROR(v))==(v))
+typedef char l_mirror_check[MIRRORED(0x01) && MIRRORED(0x02) && MIRRORED(0x04) && MIRRORED(0x08) &&
+                            MIRRORED(0x10) && MIRRORED(0x20) && MIRRORED(0x40) && MIRRORED(0x80) ? 1 : -1];
 
 
 
@@ -60,15 +150,40 @@ MCUCSR&=~0x20;
 EMCUCR&=~0x80;
 GICR=0x00;		// disable INT0
 
-for (uint8_t i=0;i<ROWS;i++)
+// stop the scan while its state is reset, a button press blanks the display
+// through here with the interrupt running
+TIMSK=0x00;
+TCCR1B=0x08;
+
+for (uint8_t k=0;k<2;k++)
    {
-   for (uint8_t j=0;j<4;j++)
+   for (uint8_t i=0;i<ROWS;i++)
       {
-   	  l_port[i][j][0]=0xff; // A and B
-   	  l_port[i][j][1]=0xff; // D
-	  }
+      for (uint8_t j=0;j<LED_PLANES;j++)
+         {
+   	     l_buffer[k][i][j][0]=0xff; // A and B
+   	     l_buffer[k][i][j][1]=0xff; // D
+	     }
+      }
+   }
+for (uint8_t k=0;k<2;k++) // nothing lit
+   {
+   l_lit_rows[k].slots=1;
+   l_lit_rows[k].dark=(ROWS-1)*LED_ROW_TIME;
+   memset(l_lit_rows[k].row,0xff,ROWS+1);
    }
 for (uint16_t i=0;i<ROWS*ROWS;i++) l[i]=0;
+l_dirty=0;
+l_stale=0;
+l_lit=0;
+l_swap=0;
+for (uint8_t i=0;i<LED_PLANES;i++) led_period[i]=LED_BASE<<i;
+#if LED_COMPENSATE
+led_period[LED_PLANES]=l_scan_lit->dark;
+#endif
+led_time=0;
+led_next=&l_scan_lit->row[ROWS];
+led_phase=LED_PHASES-1; // the first interrupt starts a scan
 
 // set data direction for matrix driving pins to output
 DDRA=0xff;
@@ -88,7 +203,7 @@ PORTE=0x00;
 TCCR1A=0x00; // CTC mode
 TCCR1B=0x08; // no clock yet
 TCNT1=0;     // clear counter (not really necessary after reset)
-OCR1A=256;   // 
+OCR1A=LED_BASE;
 TIMSK=0x40;  // enable compare A interrupt
 TIFR=0x40;	 // clear possible pending flag (not really necessary, but nice)
 TCCR1B=0x09; // start - full speed
@@ -96,73 +211,332 @@ TCCR1B=0x09; // start - full speed
 
 
 
+// Takes l_port for writing. A swap still waiting for the start of the scan is held
+// back, so l_port cannot turn into the scanned buffer halfway through. Returns 1 if
+// a swap was held back: l_port then already has everything written since the last one.
+uint8_t led_claim(void)
+{
+uint8_t pending;
+cli();
+pending=l_swap;
+l_swap=0;
+sei();
+return(pending);
+}
+
+
+
 void led_set(uint8_t x, uint8_t y, uint8_t value)
 {
 uint8_t port;
 uint8_t bit;
-port=X[x].port;
-bit=1<<X[x].bit;
-if (value&0x01)
+uint16_t stale=0;
+if (!led_claim()) // swapped since the last frame: l_port lacks the stale rows
    {
-   l_port[y][0][port]&=~bit;
+   stale=l_stale;
+   l_stale=0;
    }
-else
+for (uint8_t j=0;stale;j++,stale>>=1)
    {
-   l_port[y][0][port]|=bit;
+   if (stale&1) memcpy(l_port[j],l_scan[j],sizeof(l_buffer[0][0]));
    }
-if (value&0x02)
+l_stale|=(uint16_t)1<<y; // the scanned buffer lacks it after the swap
+port=pgm_read_byte(&X[x].port);
+bit=1<<pgm_read_byte(&X[x].bit);
+value=L_LEVEL(value&0x0f);
+for (uint8_t i=0;i<LED_PLANES;i++,value>>=1)
    {
-   l_port[y][1][port]&=~bit;
+   if (value&0x01)
+      {
+	  l_port[y][i][port]&=~bit;
+	  }
+   else
+      {
+	  l_port[y][i][port]|=bit;
+	  }
    }
-else
+l_relit((uint16_t)1<<y);
+l_publish();
+}
+
+
+
+// finds which of the rows (bit n = row n) of l_port have a lit led for l_lit
+void l_relit(uint16_t rows)
+{
+uint8_t all;
+for (uint8_t j=0;j<ROWS;j++,rows>>=1)
+   {
+   if (!(rows&1)) continue;
+   all=0xff; // ports are active low
+   for (uint8_t i=0;i<LED_PLANES;i++) all&=l_port[j][i][0]&l_port[j][i][1];
+   if (all==0xff) l_lit&=~((uint16_t)1<<j);
+   else l_lit|=(uint16_t)1<<j;
+   }
+}
+
+
+
+// has l_port shown from the next scan, writing its lit rows (l_lit) for the
+// interrupt. Called after led_claim() and the changes to l_port
+void l_publish(void)
+{
+struct lit_rows *lit=l_port_lit;
+uint16_t rows=l_lit;
+uint8_t n=0;
+for (uint8_t j=0;j<ROWS;j++,rows>>=1)
    {
-   l_port[y][1][port]|=bit;
+   if (rows&1) lit->row[n++]=j;
    }
-if (value&0x04)
+lit->slots=n ? n : 1; // a phase of no rows lasts one row
+lit->dark=(ROWS-lit->slots)*LED_ROW_TIME;
+while (n<=ROWS) lit->row[n++]=0xff;
+l_swap=1;
+}
+
+
+
+// repacks the rows marked in l_dirty into l_port and has it shown from the next scan
+void l2led()
+{
+uint8_t j,v,lit;
+const uint8_t *row;
+uint8_t (*port)[LED_PLANES][2];
+uint8_t ab[LED_PLANES],d[LED_PLANES]; // the A/B and D bytes of each plane, 1 lit
+#if LED_PLANES>4
+uint8_t level[ROWS];
+#endif
+uint16_t bit;
+uint16_t dirty=l_dirty;
+if (!dirty) return;
+l_dirty=0;
+if (led_claim())
    {
-   l_port[y][2][port]&=~bit;
+   l_stale|=dirty;
    }
 else
    {
-   l_port[y][2][port]|=bit;
+   uint16_t stale=l_stale;
+   l_stale=dirty;
+   dirty|=stale;
    }
-if (value&0x08)
+port=l_port;
+for(j=0;j<16;j++,dirty>>=1)
    {
-   l_port[y][3][port]&=~bit;
+   if (!(dirty&1)) continue;
+   row=&l[j*16];
+#if LED_PLANES>4
+   for (uint8_t i=0;i<ROWS;i++) level[i]=pgm_read_byte(&l_level[row[i]&0x0f]);
+   row=level;
+#endif
+   L_PACK(0,row,ab);
+   L_PACK(1,row,d);
+   lit=0;
+   L_STORES
+   bit=(uint16_t)1<<j;
+   if (lit) l_lit|=bit;
+   else l_lit&=~bit;
    }
-else
+l_publish();
+}
+
+
+
+// lights a row, its cathode bytes c, e and a (with the A columns), for exactly
+// 3*(n+1) cycles: after a pin's out come 2 outs, the loop (3*n-1), a nop and its off
+#ifdef SIM
+#define LED_LIGHT(c,e,a,n) do { \
+   PORTC=(c); \
+   PORTE=(e); \
+   PORTA=(a); \
+   led_spin(3*((n)+1)); \
+   PORTC=0x00; \
+   PORTE=0x00; \
+   PORTA=0x07; \
+   } while (0)
+#else
+#define LED_LIGHT(c,e,a,n) do { \
+   uint8_t count_=(n); \
+   asm volatile ( \
+   "out %[pc],%[c]\n\t" \
+   "out %[pe],%[e]\n\t" \
+   "out %[pa],%[a]\n\t" \
+   "1: dec %[n]\n\t" \
+   "brne 1b\n\t" \
+   "nop\n\t" \
+   "out %[pc],__zero_reg__\n\t" \
+   "out %[pe],__zero_reg__\n\t" \
+   "out %[pa],%[off]\n\t" \
+   :[n] "+r" (count_) \
+   :[c] "r" (c),[e] "r" (e),[a] "r" (a),[off] "r" ((uint8_t)0x07), \
+   [pc] "I" (_SFR_IO_ADDR(PORTC)),[pe] "I" (_SFR_IO_ADDR(PORTE)),[pa] "I" (_SFR_IO_ADDR(PORTA))); \
+   } while (0)
+#endif
+
+
+
+// lights the rows of a short phase from one interrupt, each for exactly the phase's
+// time (LED_LIGHT()), and sets up the next row with all of them dark, so the setup
+// (LED_FAST_ROW) lengthens the phase but does not change its light. Called at the
+// start of a phase with a lit row and the rows off.
+void led_fast(void)
+{
+uint8_t *ptr;
+uint8_t *next=l_scan_lit->row;
+uint8_t phase=led_phase;
+uint8_t n=((LED_BASE/3)<<phase)-1; // LED_BASE<<phase cycles
+OCR1A=0xffff; // no compare match while lighting
+if (!led_button) // leds stay off while the button is down
    {
-   l_port[y][3][port]|=bit;
+   for (uint8_t row=*next++;row<ROWS;row=*next++)
+      {
+	  ptr=l_scan[row][phase];
+	  PORTD=ptr[1];
+	  PORTB=ptr[0]&0x1f;
+	  LED_LIGHT(pgm_read_byte(&Y[row].c),pgm_read_byte(&Y[row].e),
+	     ((ptr[0]>>5)&0x07)|pgm_read_byte(&Y[row].a),n);
+	  led_spin(LED_FAST_ROW);
+	  }
    }
+OCR1A=TCNT1+16; // the next interrupt ends the phase, the match must not be missed
+led_next=&l_scan_lit->row[ROWS];
 }
 
 
 
-void l2led()
+// rotates n bytes at p left by k, in place
+void l_rotate(uint8_t *p, uint16_t n, uint16_t k)
 {
-uint8_t i,j,tmp;
-uint16_t tmp0,tmp1,tmp2,tmp3;
-for(j=0;j<16;j++)
+uint8_t *a,*b,tmp;
+if ((k==0) || (k>=n)) return;
+for (uint8_t i=0;i<3;i++) // reverse the first k, the rest, then all
    {
-   tmp0=0;tmp1=0;tmp2=0;tmp3=0;
-   for(i=0;i<16;i++)
+   a=(i==1) ? p+k : p;
+   b=(i==0) ? p+k-1 : p+n-1;
+   for (;a<b;a++,b--)
       {
-	  tmp=l[j*16+l_order[i]];
-	  tmp0=(tmp0<<1)|((tmp&0x01) ? 0 : 1);
-	  tmp1=(tmp1<<1)|((tmp&0x02) ? 0 : 1);
-	  tmp2=(tmp2<<1)|((tmp&0x04) ? 0 : 1);
-	  tmp3=(tmp3<<1)|((tmp&0x08) ? 0 : 1);
+	  tmp=*a;
+	  *a=*b;
+	  *b=tmp;
 	  }
-   *(uint16_t *)&l_port[j][0][0]=tmp0;
-   *(uint16_t *)&l_port[j][1][0]=tmp1;
-   *(uint16_t *)&l_port[j][2][0]=tmp2;
-   *(uint16_t *)&l_port[j][3][0]=tmp3;
    }
 }
 
 
 
-// led update interrupt at variable rate for 4 scans per about 2KHz
+// rotates the frame on display like OP_ROTATE rotates l[] (s as in animate()),
+// working on the packed bitplanes instead of repacking. The caller rotates l[]
+// alongside, the rows in l_dirty are packed before.
+void l_scroll(uint8_t s)
+{
+uint8_t amount=s&0x0f;
+uint8_t *p,*end,tmp;
+l2led();
+if (!led_claim() && l_stale) memcpy(l_port,l_scan,sizeof(l_buffer[0])); // l_port lacks rows
+l_stale=0xffff;
+p=(uint8_t *)l_port;
+end=p+sizeof(l_buffer[0]);
+if (s&0x10) for (uint8_t i=0;i<amount;i++) // left
+   {
+   for (uint8_t *q=p;q<end;q+=2)
+      {
+	  tmp=q[0];
+	  q[0]=pgm_read_byte(&l_mirror[q[1]]);
+	  q[1]=pgm_read_byte(&l_left[tmp]);
+	  }
+   }
+if (s&0x20) l_rotate(p,sizeof(l_buffer[0]),amount*LED_PLANES*2); // up
+if (s&0x40) for (uint8_t i=0;i<amount;i++) // right
+   {
+   for (uint8_t *q=p;q<end;q+=2)
+      {
+	  tmp=q[0];
+	  q[0]=pgm_read_byte(&l_right[q[1]]);
+	  q[1]=pgm_read_byte(&l_mirror[tmp]);
+	  }
+   }
+if (s&0x80) l_rotate(p,sizeof(l_buffer[0]),sizeof(l_buffer[0])-amount*LED_PLANES*2); // down
+if (s&0xa0) l_relit(0xffff); // the rows moved
+l_publish();
+}
+
+
+
+#ifdef SIM
+// portable version of the interrupt below for the host simulator, keep the two in step
+ISR(TIMER1_COMPA_vect)
+{
+uint8_t *ptr;
+uint8_t row;
+PORTA=0x07; // rows off, B keeps its columns until the row is written
+PORTC=0x00;
+PORTE=0x00;
+PORTD=0xff; // the button is on D2
+row=*led_next++;
+led_button=~PIND&0x04; // every interrupt, also while nothing is lit
+if (row>=ROWS) // the 0xff after the last row: next phase
+   {
+   led_phase++;
+#if LED_COMPENSATE
+   if (led_phase==LED_PLANES && !led_period[LED_PLANES]) led_phase++; // no dark time
+#endif
+   if (led_phase==LED_PHASES) led_phase=0;
+   if (led_phase==0)
+      {
+#if LED_COMPENSATE
+	  led_tick++;
+#else
+	  led_time+=l_scan_lit->slots; // a tick stays 16 row times however many are lit
+	  if (led_time>=ROWS)
+	     {
+		 led_time-=ROWS;
+		 led_tick++;
+		 }
+#endif
+	  if (l_swap)
+	     {
+		 uint8_t (*tmp)[LED_PLANES][2]=l_scan;
+		 struct lit_rows *tmp_lit=l_scan_lit;
+		 l_scan=l_port;
+		 l_port=tmp;
+		 l_scan_lit=l_port_lit;
+		 l_port_lit=tmp_lit;
+#if LED_COMPENSATE
+		 led_period[LED_PLANES]=l_scan_lit->dark;
+#endif
+		 l_swap=0;
+		 }
+	  }
+   OCR1A=led_period[led_phase];
+   led_next=l_scan_lit->row;
+#if LED_COMPENSATE
+   if (led_phase==LED_PLANES) led_next+=ROWS; // the dark phase: at the 0xff
+#endif
+   row=*led_next++;
+   if (row>=ROWS) // no lit rows, the next interrupt ends the phase
+      {
+	  led_next--;
+	  return;
+	  }
+   }
+led_row=row;
+#if LED_FAST_PHASES
+if (led_phase<LED_FAST_PHASES)
+   {
+   led_fast();
+   return;
+   }
+#endif
+if (led_button) return;
+ptr=l_scan[led_row][led_phase];
+PORTD=ptr[1];
+PORTB=ptr[0]&0x1f;
+PORTC=pgm_read_byte(&Y[led_row].c);
+PORTE=pgm_read_byte(&Y[led_row].e);
+PORTA=((ptr[0]>>5)&0x07)|pgm_read_byte(&Y[led_row].a);
+}
+#else
+// led update interrupt at variable rate for LED_PLANES scans per about 2KHz
 ISR(TIMER1_COMPA_vect,ISR_NAKED)
 {
 // enter interrupt
@@ -174,116 +548,243 @@ asm volatile (
 "push r30\n\t"
 "push r31\n\t"
 "clr r17\n\t"
-::);
+:::);
 
-// increment row, update phase and ms
+// disable all rows, and D's columns for the button on D2 (r17 is 0)
 asm volatile (
-"lds r16,led_row\n\t"
-"inc r16\n\t"
-"andi r16,0x0f\n\t"
-"sts led_row,r16\n\t"
-"brne done\n\t"
+"ldi r16,0x07\n\t" "out %0,r16\n\t"
+"out %1,r17\n\t"
+"out %2,r17\n\t"
+"ldi r16,0xff\n\t" "out %3,r16\n\t"
+:
+:"I" (_SFR_IO_ADDR(PORTA)),
+"I" (_SFR_IO_ADDR(PORTC)),
+"I" (_SFR_IO_ADDR(PORTE)),
+"I" (_SFR_IO_ADDR(PORTD))
+);
+
+// test button, on every interrupt so that a blank frame still sees it
+// released, PIND settled during the two lds
+asm volatile (
+"lds r30,led_next\n\t"
+"lds r31,led_next+1\n\t"
+"in r16,%0\n\t"
+"com r16\n\t"
+"andi r16,0x04\n\t"
+"sts led_button,r16\n\t"
+:
+:"I" (_SFR_IO_ADDR(PIND))
+);
+
+// next row from l_scan_lit, at the 0xff after the last one update phase and ms
+asm volatile (
+"ld r16,Z+\n\t"
+"cpi r16,%3\n\t"
+"brsh next_phase\n\t"
+"rjmp next_row\n\t" // out of a branch's reach
+"next_phase:\n\t"
 "lds r16,led_phase\n\t"
 "inc r16\n\t"
-"andi r16,0x03\n\t"
+"cpi r16,%2\n\t"
+"brlo phase_ready\n\t"
+#if LED_COMPENSATE
+"brne phase_wrap\n\t" // after the dark phase
+"lds r30,led_period+%6\n\t"
+"lds r31,led_period+%6+1\n\t"
+"or r30,r31\n\t"
+"brne phase_ready\n\t" // the dark phase, if there is dark time
+"phase_wrap:\n\t"
+#endif
+"clr r16\n\t"
+"phase_ready:\n\t"
 "sts led_phase,r16\n\t"
+"tst r16\n\t"
 "brne tick_ready\n\t"
+#if LED_COMPENSATE
 "lds r16,led_tick\n\t"
 "inc r16\n\t"
 "sts led_tick,r16\n\t"
+#else
+"lds r30,l_scan_lit\n\t" // a tick is 16 row times, add the scan's
+"lds r31,l_scan_lit+1\n\t"
+"ld r17,Z\n\t"
+"lds r16,led_time\n\t"
+"add r16,r17\n\t"
+"cpi r16,%3\n\t"
+"brlo time_ready\n\t"
+"subi r16,%3\n\t"
+"lds r17,led_tick\n\t"
+"inc r17\n\t"
+"sts led_tick,r17\n\t"
+"time_ready:\n\t"
+"sts led_time,r16\n\t"
+#endif
+"lds r16,l_swap\n\t" // new frame ready - swap buffers
+"tst r16\n\t"
+"breq noswap\n\t"
+"lds r16,l_scan\n\t"
+"lds r17,l_port\n\t"
+"sts l_scan,r17\n\t"
+"sts l_port,r16\n\t"
+"lds r16,l_scan+1\n\t"
+"lds r17,l_port+1\n\t"
+"sts l_scan+1,r17\n\t"
+"sts l_port+1,r16\n\t"
+"lds r16,l_scan_lit\n\t"
+"lds r17,l_port_lit\n\t"
+"sts l_scan_lit,r17\n\t"
+"sts l_port_lit,r16\n\t"
+"lds r16,l_scan_lit+1\n\t"
+"lds r17,l_port_lit+1\n\t"
+"sts l_scan_lit+1,r17\n\t"
+"sts l_port_lit+1,r16\n\t"
+#if LED_COMPENSATE
+"lds r30,l_scan_lit\n\t" // the new frame's dark time
+"lds r31,l_scan_lit+1\n\t"
+"ldd r16,Z+%5\n\t"
+"sts led_period+%6,r16\n\t"
+"ldd r16,Z+%5+1\n\t"
+"sts led_period+%6+1,r16\n\t"
+#endif
+"clr r17\n\t"
+"sts l_swap,r17\n\t"
+"noswap:\n\t"
 "clr r16\n\t"
+"clr r17\n\t"
 "tick_ready:\n\t"
-"sec\n\t"
-"clockloop:\n\t"
-"rol r17\n\t"
-"dec r16\n\t"
-"brpl clockloop\n\t"
+"ldi r30,lo8(led_period)\n\t"
+"ldi r31,hi8(led_period)\n\t"
+"lsl r16\n\t"
+"add r30,r16\n\t"
+"adc r31,r17\n\t"
+"ld r16,Z+\n\t"
+"ld r17,Z\n\t"
 "out %0,r17\n\t"
+"out %1,r16\n\t"
 "clr r17\n\t"
-"out %1,r17\n\t"
-"done:\n\t"
+"lds r30,l_scan_lit\n\t" // the phase's first row
+"lds r31,l_scan_lit+1\n\t"
+"adiw r30,%4\n\t"
+#if LED_COMPENSATE
+"lds r16,led_phase\n\t"
+"cpi r16,%2\n\t"
+"brne first_row\n\t"
+"adiw r30,%3\n\t" // the dark phase: at the 0xff
+"first_row:\n\t"
+#endif
+"ld r16,Z+\n\t"
+"cpi r16,%3\n\t"
+"brlo next_row\n\t"
+"sbiw r30,1\n\t" // no lit rows, the next interrupt ends the phase
+"sts led_next,r30\n\t"
+"sts led_next+1,r31\n\t"
+"rjmp return\n\t"
+"next_row:\n\t"
+"sts led_next,r30\n\t"
+"sts led_next+1,r31\n\t"
+"sts led_row,r16\n\t"
 :
 :"I" (_SFR_IO_ADDR(OCR1AH)),
-"I" (_SFR_IO_ADDR(OCR1AL))
+"I" (_SFR_IO_ADDR(OCR1AL)),
+"M" (LED_PLANES),
+"M" (ROWS),
+"I" (offsetof(struct lit_rows,row)),
+"I" (offsetof(struct lit_rows,dark)),
+"M" (2*LED_PLANES)
 );
 
-// disable all columns and rows
+#if LED_FAST_PHASES
+// short phase - all rows from led_fast(), saving what C code may use
 asm volatile (
-"ldi r16,0x07\n\t" "out %0,r16\n\t"
-"ldi r16,0x1f\n\t" "out %1,r16\n\t"
-"ldi r16,0x00\n\t" "out %2,r16\n\t"
-"ldi r16,0xff\n\t" "out %3,r16\n\t"
-"ldi r16,0x00\n\t" "out %4,r16\n\t"
+"lds r16,led_phase\n\t"
+"cpi r16,%0\n\t"
+"brsh slow\n\t"
+"push r0\n\t"
+"push r1\n\t"
+"push r18\n\t" "push r19\n\t" "push r20\n\t" "push r21\n\t"
+"push r22\n\t" "push r23\n\t" "push r24\n\t" "push r25\n\t"
+"push r26\n\t" "push r27\n\t"
+"clr r1\n\t"
+"call led_fast\n\t"
+"pop r27\n\t" "pop r26\n\t"
+"pop r25\n\t" "pop r24\n\t" "pop r23\n\t" "pop r22\n\t"
+"pop r21\n\t" "pop r20\n\t" "pop r19\n\t" "pop r18\n\t"
+"pop r1\n\t"
+"pop r0\n\t"
+"rjmp return\n\t"
+"slow:\n\t"
 :
-:"I" (_SFR_IO_ADDR(PORTA)),
-"I" (_SFR_IO_ADDR(PORTB)),
-"I" (_SFR_IO_ADDR(PORTC)),
-"I" (_SFR_IO_ADDR(PORTD)),
-"I" (_SFR_IO_ADDR(PORTE))
+:"M" (LED_FAST_PHASES)
 );
+#endif
 
-// test button
+// leds stay off while the button is down
 asm volatile (
-"in r16,%0\n\t"
-"com r16\n\t"
-"andi r16,0x04\n\t"
-"sts led_button,r16\n\t"
+"lds r16,led_button\n\t"
+"tst r16\n\t"
 "brne return\n\t"
-:
-:"I" (_SFR_IO_ADDR(PIND))
-);
+::);
 
 // first A2 A1 A0 B4 B3 B2 B1 B0 second: D7 D6 D5 D4 D3 D2 D1 D0
-// update X-driving port bits from a pre-calculated table
+// update X-driving port bits from a pre-calculated table, A's wait in r16 for the row
 asm volatile (
+"lds r30,l_scan\n\t"
+"lds r31,l_scan+1\n\t"
 "lds r16,led_row\n\t"
 "lsl r16\n\t"
 "lsl r16\n\t"
+#if LED_PLANES==6
+"mov r17,r16\n\t" // row*12
+"lsl r16\n\t"
+"add r16,r17\n\t"
+"clr r17\n\t"
+#else
 "lsl r16\n\t"
+#endif
+#if LED_PLANES==8
+"lsl r16\n\t"
+#endif
 "add r30,r16\n\t"
 "adc r31,r17\n\t"
 "lds r16,led_phase\n\t"
 "lsl r16\n\t"
 "add r30,r16\n\t"
 "adc r31,r17\n\t"
-"ld r16,Z\n\t"
+"ld r16,Z+\n\t"
+"ld r17,Z\n\t"
+"out %1,r17\n\t"
+"mov r17,r16\n\t"
+"andi r17,0x1f\n\t"
+"out %0,r17\n\t"
 "swap r16\n\t"
 "lsr r16\n\t"
 "andi r16,0x07\n\t"
-"out %1,r16\n\t"
-"ld r16,Z+\n\t"
-"andi r16,0x1f\n\t"
-"out %2,r16\n\t"
-"ld r16,Z\n\t"
-"out %3,r16\n\t"
 :
-: "z" ((uint8_t*) &l_port[0][0][0]),
-  "I" (_SFR_IO_ADDR(PORTA)),
-  "I" (_SFR_IO_ADDR(PORTB)),
+: "I" (_SFR_IO_ADDR(PORTB)),
   "I" (_SFR_IO_ADDR(PORTD))
 );
 
-// turn on line bit (y)
+// turn on the row (y): whole C and E from Y[] in flash, then A with its columns
 asm volatile (
-"lds r16,led_row\n\t"
-"lsl r16\n\t"
-"add r30,r16\n\t"
-"adc r31,r17\n\t"
-"ld r16,Z+\n\t"
-"ld r17,Z+\n\t"
-"mov r30,r16\n\t"
-"clr r31\n\t"
-"clr r16\n\t"
-"sec\n\t"
-"shiftloop:\n\t"
-"rol r16\n\t"
-"dec r17\n\t"
-"brpl shiftloop\n\t"
-"ld r17,Z\n\t"
-"or r17,r16\n\t"
-"st Z,r17\n\t"
+"lds r17,led_row\n\t"
+"lsl r17\n\t"
+"lsl r17\n\t"
+"add r30,r17\n\t"
+"brcc row_ready\n\t"
+"inc r31\n\t"
+"row_ready:\n\t"
+"lpm r17,Z+\n\t"
+"out %0,r17\n\t"
+"lpm r17,Z+\n\t"
+"out %1,r17\n\t"
+"lpm r17,Z\n\t"
+"or r16,r17\n\t"
+"out %2,r16\n\t"
 :
-: "z" ((uint8_t*) &Y[0])
+: "I" (_SFR_IO_ADDR(PORTC)),
+  "I" (_SFR_IO_ADDR(PORTE)),
+  "I" (_SFR_IO_ADDR(PORTA)),
+  "z" ((const uint8_t*) &Y[0])
 );
 
 // return from interrupt
@@ -298,4 +799,4 @@ asm volatile (
 "reti\n\t"
 ::);
 }
-
+#endif
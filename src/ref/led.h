@@ -1,17 +1,108 @@
 
 #include <avr/io.h>
 
+#include "../pins.h" // generated from info/pins.txt
+
 #define ROWS 16
 
+// bitplanes per scan: 4, 6 or 8. l[] keeps 16 brightness values, with more planes
+// they are spread on a square law so the dim end gets the finer steps. At 8 planes
+// static data takes about 890 of the ATmega162's 1024 bytes of SRAM (l_buffer 512,
+// l 256), leaving some 135 for the stack, where main, animate(), l2led() and the
+// interrupt need about 100 (estimates, not avr-size output)
+#ifndef LED_PLANES
+#define LED_PLANES 4
+#endif
+#if (LED_PLANES!=4) && (LED_PLANES!=6) && (LED_PLANES!=8)
+#error LED_PLANES must be 4, 6 or 8
+#endif
+
+// the interrupt scans only the rows with a lit led. With LED_COMPENSATE 1 a scan
+// still takes 16 rows' time, the rest spent dark in one extra phase, so a frame looks
+// as bright however many rows it lights. With 0 the lit rows share the whole time: a
+// frame of few rows is brighter and refreshed faster, at more interrupt load
+#ifndef LED_COMPENSATE
+#define LED_COMPENSATE 1
+#endif
+#define LED_PHASES (LED_PLANES+LED_COMPENSATE)
+
+// OCR1A of the shortest phase, phase n lasts LED_BASE<<n cycles per row. The
+// scan rate stays the same at every depth (256 cycles for 4 planes).
+#define LED_BASE (256U*15/((1<<LED_PLANES)-1))
+#define LED_ROW_TIME (LED_BASE*((1<<LED_PLANES)-1)) // a row through all the phases
+
+// interrupt cost of the asm in led.c: a row, and what led_fast() adds besides the
+// rows it lights. Used for LED_FAST_CYCLES and the simulator's load report. Unverified:
+// counted by hand, not measured with avr-objdump or a cycle-exact simulator (a
+// recount of a 4-plane row gives 112, 119 with the interrupt response). Any value
+// from 57 to 176 picks the same fast phases at every depth
+#define LED_ISR_CYCLES  110
+#define LED_FAST_EXTRA  60
+
+// phases shorter than LED_FAST_CYCLES are lit from one interrupt (led_fast()): an
+// interrupt per row would still be running when the next is due. That is phases 0
+// and 1 at 6 planes (60 and 120 cycles), 0 - 3 at 8 (15 - 120), none at 4.
+#define LED_FAST_CYCLES (LED_ISR_CYCLES+64)
+#define LED_FAST_PHASES ((LED_BASE<LED_FAST_CYCLES)+(LED_BASE*2<LED_FAST_CYCLES)+ \
+                         (LED_BASE*4<LED_FAST_CYCLES)+(LED_BASE*8<LED_FAST_CYCLES)+ \
+                         (LED_BASE*16<LED_FAST_CYCLES)+(LED_BASE*32<LED_FAST_CYCLES))
+// led_fast() lights a row for exactly LED_BASE<<n cycles, counted by a 3-cycle loop,
+// then sets up the next one with every row dark. Setting up takes LED_FAST_ROW cycles
+// a row (hand count, unverified), more than the 15 and 30 cycles of the shortest
+// phases at 8 planes: it lengthens the scan, 2% at 6 planes and 5% at 8, but lights nothing
+#define LED_FAST_ROW 45
+#if LED_FAST_PHASES && ((LED_BASE%3) || (LED_BASE<6))
+#error LED_BASE must be a multiple of 3 from 6 for led_fast()
+#endif
+
+#ifdef SIM
+#include "sim.h"
+#define led_idle() sim_step() // let simulated time pass in busy-wait loops
+#define led_spin(cycles) sim_delay(cycles)
+#else
+#define led_idle()
+#define led_spin(cycles)
+#endif
+
 void led_init(void);
 void led_set(uint8_t x, uint8_t y, uint8_t value);
 void l2led();
+void l_relit(uint16_t rows);
+void l_publish(void);
+uint8_t led_claim(void);
+void led_fast(void);
+void l_rotate(uint8_t *p, uint16_t n, uint16_t k);
+void l_scroll(uint8_t s);
 
 extern volatile uint8_t led_tick,led_phase,led_button;
+extern uint16_t led_period[LED_PHASES];
 extern uint8_t  l[];
-extern uint8_t  l_port[][4][2];
+extern uint16_t l_dirty;
+extern uint8_t  l_buffer[2][ROWS][LED_PLANES][2];
+extern uint8_t  (*volatile l_port)[LED_PLANES][2];
+extern uint8_t  (*volatile l_scan)[LED_PLANES][2];
+extern volatile uint8_t l_swap;
+extern uint16_t l_stale;
+extern uint16_t l_lit;
 
+// anode of a column: byte 0 (A and B) or 1 (D) of an l_port word, and the bit
 struct line {
 uint8_t port;
 uint8_t bit;
 };
+
+// rows of a frame with a lit led, l_publish() writes them for the interrupt
+struct lit_rows {
+uint8_t  slots;       // row times a scan takes: the lit rows, at least 1
+uint16_t dark;        // LED_COMPENSATE: the other row times of 16, spent dark
+uint8_t  row[ROWS+1]; // the lit rows top to bottom, then 0xff to the end
+};
+
+// cathode of a row: whole PORTC and PORTE and the cathode bits of PORTA while it
+// is lit, padded to 4 bytes so the interrupt indexes it with two shifts
+struct cathode {
+uint8_t c;
+uint8_t e;
+uint8_t a;
+uint8_t unused;
+};
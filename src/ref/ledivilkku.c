@@ -1,10 +1,13 @@
 #include <avr/io.h>
 #include <avr/interrupt.h>
 #include <avr/pgmspace.h> 
+#include <avr/sleep.h>
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "led.h"
+#include "script.h"
 
 // Students notice: This program uses global variables, which would be bad design for any larger systems than this.
 // Not that the design were particularly elegant to begin with
@@ -14,17 +17,26 @@ void tick(void);
 void matrix(void);
 void animate(void);
 void setanimation(void);
-uint16_t animate_parsevalue(uint8_t digits);
-uint8_t animate_hex2dec(uint8_t character);
+void animate_track(uint8_t i);
+void animate_retrack(void);
+void animate_rotate(uint8_t s);
+void animate_plot(uint8_t i);
+void animate_span(uint8_t y, uint8_t x0, uint8_t x1);
+void animate_draw(uint8_t op, uint8_t from, uint8_t to);
 void powerdown(void);
 
 
-extern const char animation[];
+extern const uint8_t animation[];
+extern const uint16_t animation_start[];
+extern const uint8_t animation_sequences;
 uint8_t animationsequence=0;
 
-PGM_P a_ptr;   // pointer to animation script in PROGMEM
+const uint8_t *a_ptr;   // pointer to animation code in PROGMEM
 uint16_t a_w;  // animation wait counter
 uint8_t a_e;   // animation selected effect
+uint8_t a_blit; // l_port holds a blitted frame, l[] is not on display
+uint16_t a_fade[ROWS]; // leds that may have automatic animation (0x10) on, bit x of row y
+uint16_t a_fade_rows;  // rows with a bit set in a_fade
 
 
 
@@ -70,10 +82,11 @@ void animate(void)
 {
 uint8_t a_b;
 uint8_t a_s;
+uint8_t amount;
 while (a_w==0) // loop until we reach wait statement - or are already waiting
    {
    a_b=pgm_read_byte_near(a_ptr++);
-   if ((a_b=='x') || (a_b==0)) // end reached - reset and wait for one cycle (to defend against empty lists)
+   if ((a_b==OP_NEXT) || (a_b==OP_END)) // end reached - reset and wait for one cycle (to defend against empty lists)
 	  {
       setanimation();
 	  //a_ptr=animation;
@@ -81,42 +94,74 @@ while (a_w==0) // loop until we reach wait statement - or are already waiting
 	  }
    switch(a_b)
       {
-	  case 'e':
-	     a_e=animate_parsevalue(2);
+	  case OP_EFFECT:
+	     a_e=pgm_read_byte_near(a_ptr++);
 	     break;
-	  case 's':
-	     l[animate_parsevalue(2)]=a_e;
+	  case OP_BLIT:
+	     led_claim();
+	     memcpy_P(l_port,a_ptr,BLIT_SIZE);
+	     l_relit(0xffff);
+	     l_publish();
+	     a_ptr+=BLIT_SIZE;
+	     a_blit=1;
+	     l_dirty=0;
+	     l_stale=0xffff; // the scanned buffer has none of it
 	     break;
-	  case 'a':
+	  case OP_SET:
+	     a_s=pgm_read_byte_near(a_ptr++);
+	     l[a_s]=a_e;
+	     l_dirty|=(uint16_t)1<<(a_s>>4);
+	     if (a_e&0x10) animate_track(a_s);
+	     break;
+	  case OP_SETN:
+	     a_s=pgm_read_byte_near(a_ptr++);
+	     while (a_s--)
+	        {
+	        uint8_t a_i=pgm_read_byte_near(a_ptr++);
+	        l[a_i]=a_e;
+	        l_dirty|=(uint16_t)1<<(a_i>>4);
+	        if (a_e&0x10) animate_track(a_i);
+	        }
+	     break;
+	  case OP_ALL:
 	     for (uint16_t i=0;i<256;i++) l[i]=a_e;
+	     l_dirty=0xffff;
+	     animate_retrack();
 	     break;
-	  case 'p':
-	     a_s=animate_parsevalue(2);
-		 uint8_t amount = a_s&0x0f;
-		 if (a_s&0x10) for (uint8_t i=0;i<16;i++) // shift left
-		    {
-			uint8_t offset = i<<4;
-			for (uint8_t j=0;j<16-amount;j++)
-			   {
-			   l[offset+j]=l[offset+j+amount];
-			   }
-			}
-		 amount = (a_s&0x0f)<<4;
-		 if (a_s&0x20) for (int16_t i=0;i<256-amount;i++) l[i]=l[i+amount];// shift up
-		 amount = a_s&0x0f;
-		 if (a_s&0x40) for (uint8_t i=0;i<16;i++) // shift right
-		    {
-			uint8_t offset = i<<4;
-			for (uint8_t j=15;j>=amount;j--)
-			   {
-			   l[offset+j]=l[offset+j-amount];
-			   }
-			}
-		 amount = (a_s&0x0f)<<4;
-		 if (a_s&0x80) for (int16_t i=255;i>=amount;i--) l[i]=l[i-amount];// shift down
+	  case OP_SHIFT: // vacated leds keep what they had
+	     a_s=pgm_read_byte_near(a_ptr++);
+	     l_dirty=0xffff;
+	     amount=a_s&0x0f;
+	     if (a_s&0x10) for (uint16_t i=0;i<256;i+=16) memmove(&l[i],&l[i+amount],16-amount); // left
+	     if (a_s&0x20) memmove(l,&l[amount<<4],256-(amount<<4)); // up
+	     if (a_s&0x40) for (uint16_t i=0;i<256;i+=16) memmove(&l[i+amount],&l[i],16-amount); // right
+	     if (a_s&0x80) memmove(&l[amount<<4],l,256-(amount<<4)); // down
+	     animate_retrack();
+	     break;
+	  case OP_ROTATE:
+	     a_s=pgm_read_byte_near(a_ptr++);
+	     l_dirty=0xffff;
+	     animate_rotate(a_s);
+	     break;
+	  case OP_SCROLL:
+	     a_s=pgm_read_byte_near(a_ptr++);
+	     if (a_blit && l_dirty) // drawn over the blitted frame - scroll all of l[]
+	        {
+	        a_blit=0;
+	        l_dirty=0xffff;
+	        }
+	     l_scroll(a_s); // the frame on display, no repack
+	     animate_rotate(a_s);
 	     break;
-	  case 'w':
-	     a_w=animate_parsevalue(4);
+	  case OP_LINE:
+	  case OP_RECT:
+	  case OP_FILL:
+	     animate_draw(a_b,pgm_read_byte_near(a_ptr),pgm_read_byte_near(a_ptr+1));
+	     a_ptr+=2;
+	     break;
+	  case OP_WAIT:
+	     a_w=pgm_read_word_near(a_ptr);
+	     a_ptr+=2;
 	     break;
       default:	// should never happen - reset animation to the start of current sequence
 	     setanimation();
@@ -124,17 +169,34 @@ while (a_w==0) // loop until we reach wait statement - or are already waiting
 	     break;
 	  }
    }
+if (a_blit && l_dirty) // the script drew over a blitted frame - put all of l[] back on display
+   {
+   a_blit=0;
+   l_dirty=0xffff;
+   }
 if (a_w!=0xffff) a_w--; // 0xffff equals STOP
 if (led_tick&0x03) return; // run autoanimation only every 4th tick
-uint8_t i=0;
-do {
-   uint8_t a_tmp=l[i];
-   if (a_tmp&0x10) // automatic animation command for this led
+uint16_t rows=a_fade_rows;
+uint16_t rowbit=1;
+for (uint8_t y=0;rows;y++,rows>>=1,rowbit<<=1) // only rows and leds in a_fade
+   {
+   if (!(rows&1)) continue;
+   uint8_t *ptr=&l[y<<4];
+   uint16_t fading=a_fade[y];
+   uint16_t bit=1;
+   for (uint16_t left=fading;left;left>>=1,bit<<=1,ptr++)
       {
+	  if (!(left&1)) continue;
+	  uint8_t a_tmp=*ptr;
+	  if (!(a_tmp&0x10)) // overwritten since - or finished
+	     {
+		 fading&=~bit;
+		 continue;
+		 }
 	  uint8_t a_c,a_d;
 	  a_d=a_tmp&0x0f;
 	  a_c=a_tmp&0xf0;
-      if (a_c&0x20)
+	  if (a_c&0x20)
 	     {
 		 a_d++;
 		 if (a_d&0xf0)
@@ -144,13 +206,13 @@ do {
 			   {
 			   a_c^=0x20;
 			   }
-            else
+			else
 			   {
 			   a_c&=~0x10;
 			   }
 			}
 		 }
-      else
+	  else
 	     {
 		 a_d--;
 		 if (a_d&0xf0)
@@ -160,63 +222,148 @@ do {
 			   {
 			   a_c^=0x20;
 			   }
-            else
+			else
 			   {
 			   a_c&=~0x10;
 			   }
-            }
+			}
 		 }
-      l[i]=a_c|a_d;
+	  *ptr=a_c|a_d;
 	  }
-   i++;
+   a_fade[y]=fading;
+   if (!fading) a_fade_rows&=~rowbit;
+   l_dirty|=rowbit;
    }
-while (i!=0); // loop all 256 values
+if (a_blit) l_dirty=0; // fades go on in l[] under the blitted frame
 l2led();
 }
 
 
 
-void setanimation(void)
+// adds led i to the ones the automatic animation pass looks at
+void animate_track(uint8_t i)
 {
-uint8_t seqno=0;
-uint8_t a_b;
-a_ptr=animation;
-while (seqno!=animationsequence)
+a_fade[i>>4]|=(uint16_t)1<<(i&0x0f);
+a_fade_rows|=(uint16_t)1<<(i>>4);
+}
+
+
+
+// rebuilds a_fade after l[] was rewritten wholesale
+void animate_retrack(void)
+{
+a_fade_rows=0;
+for (uint8_t y=0;y<ROWS;y++)
    {
-   a_b=pgm_read_byte_near(a_ptr++);
-   if (a_b==0) // end of program - jump to beginning
-      {
-	  animationsequence=0;
-	  a_ptr=animation;
-	  break;
-	  }
-   if (a_b=='x') seqno++;
+   uint16_t fading=0;
+   for (uint8_t x=0;x<16;x++) if (l[(y<<4)+x]&0x10) fading|=(uint16_t)1<<x;
+   a_fade[y]=fading;
+   if (fading) a_fade_rows|=(uint16_t)1<<y;
    }
-a_w=0;
 }
 
 
 
-uint16_t animate_parsevalue(uint8_t digits)
+// rotates l[] with wrap-around, s as for OP_SHIFT
+void animate_rotate(uint8_t s)
 {
-uint16_t result=0,c;
-while (digits--)
+uint8_t amount=s&0x0f;
+if (s&0x10) for (uint16_t i=0;i<256;i+=16) l_rotate(&l[i],16,amount); // left
+if (s&0x20) l_rotate(l,256,amount<<4); // up
+if (s&0x40) for (uint16_t i=0;i<256;i+=16) l_rotate(&l[i],16,16-amount); // right
+if (s&0x80) l_rotate(l,256,256-(amount<<4)); // down
+animate_retrack();
+}
+
+
+
+// sets led i to the selected effect
+void animate_plot(uint8_t i)
+{
+l[i]=a_e;
+l_dirty|=(uint16_t)1<<(i>>4);
+if (a_e&0x10) animate_track(i);
+}
+
+
+
+// sets leds x0 - x1 of row y to the selected effect
+void animate_span(uint8_t y, uint8_t x0, uint8_t x1)
+{
+memset(&l[(y<<4)+x0],a_e,x1-x0+1);
+l_dirty|=(uint16_t)1<<y;
+if (a_e&0x10)
    {
-   c=pgm_read_byte_near(a_ptr++);
-   result<<=4;
-   result+=animate_hex2dec(c);
+   a_fade[y]|=(uint16_t)(0xffff>>(15-x1+x0))<<x0;
+   a_fade_rows|=(uint16_t)1<<y;
    }
-return(result);
 }
 
 
 
-uint8_t animate_hex2dec(uint8_t character)
+// OP_LINE, OP_RECT and OP_FILL between leds from and to (YX)
+void animate_draw(uint8_t op, uint8_t from, uint8_t to)
 {
-if ((character>='0')&&(character<='9')) return(character-'0');
-if ((character>='a')&&(character<='f')) return(character+10-'a');
-if ((character>='A')&&(character<='F')) return(character+10-'A');
-return(0); // should never happen
+uint8_t x0=from&0x0f,y0=from>>4;
+uint8_t x1=to&0x0f,y1=to>>4;
+if (op==OP_LINE) // Bresenham
+   {
+   int8_t dx=(x1>x0) ? x1-x0 : x0-x1;
+   int8_t dy=(y1>y0) ? y0-y1 : y1-y0;
+   int8_t sx=(x1>x0) ? 1 : -1;
+   int8_t sy=(y1>y0) ? 16 : -16;
+   int8_t err=dx+dy;
+   int8_t e2;
+   uint8_t i=from;
+   while (1)
+      {
+	  animate_plot(i);
+	  if (i==to) break;
+	  e2=2*err;
+	  if (e2>=dy)
+	     {
+		 err+=dy;
+		 i+=sx;
+		 }
+	  if (e2<=dx)
+	     {
+		 err+=dx;
+		 i+=sy;
+		 }
+	  }
+   return;
+   }
+if (x0>x1)
+   {
+   uint8_t tmp=x0;x0=x1;x1=tmp;
+   }
+if (y0>y1)
+   {
+   uint8_t tmp=y0;y0=y1;y1=tmp;
+   }
+if (op==OP_FILL)
+   {
+   for (uint8_t y=y0;y<=y1;y++) animate_span(y,x0,x1);
+   return;
+   }
+animate_span(y0,x0,x1);
+animate_span(y1,x0,x1);
+for (uint8_t y=y0+1;y<y1;y++)
+   {
+   animate_plot((y<<4)+x0);
+   animate_plot((y<<4)+x1);
+   }
+}
+
+
+
+void setanimation(void)
+{
+if (animationsequence>=animation_sequences) animationsequence=0; // past the last - back to the first
+a_ptr=animation+pgm_read_word_near(&animation_start[animationsequence]);
+a_w=0;
+if (a_blit) l_dirty=0xffff; // l[] goes back on display
+a_blit=0;
 }
 
 
@@ -235,7 +382,7 @@ void tick(void)
 {
 uint8_t tmp;
 tmp=led_tick;
-while (tmp==led_tick);
+while (tmp==led_tick) led_idle();
 }
 
 
@@ -259,15 +406,13 @@ GIFR=0x00;		// clear pending interrupts
 GICR=0x40;		// enable INT0
 sei();
 MCUCR|=0x20; // enable sleep
-asm volatile("sleep\n");
+sleep_cpu();
 }
 
 
 
 void matrix(void)
 {
-while (led_phase==3);
-while (led_phase!=3);
 uint8_t *ptr=l;
 for (uint8_t i=255;i>255-16;i--)
    {
@@ -276,6 +421,7 @@ for (uint8_t i=255;i>255-16;i--)
    if (tmp)
       {
       ptr[i]=tmp-1;
+	  l_dirty|=0x8000;
 	  }
    }
 for (uint8_t i=255-16;i!=255;i--) // careful with sign
@@ -289,12 +435,14 @@ for (uint8_t i=255-16;i!=255;i--) // careful with sign
 		 ptr[i+16]=tmp;
 		 }
       ptr[i]=tmp-1;
+	  l_dirty|=(uint16_t)3<<(i>>4); // this row and the one below
 	  }
    }
 for (uint8_t i=0;i<16;i++) if ((rand()&0x1f)==0x1f)
    {
    rand();rand();rand();rand();rand();rand();rand();rand();
    l[i]=rand()&0x0f;
+   l_dirty|=0x0001;
    }
 for (uint8_t i=0;i<7;i++) tick();
 l2led();
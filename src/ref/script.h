@@ -0,0 +1,25 @@
+// Binary animation script opcodes run by animate().
+// The text scripts (animaatio.h) are the source form, script_to_code.py
+// (or script.hpp, at build time) compiles them to these. Word operands are little endian.
+
+#define OP_END    0x00 // end of script
+#define OP_NEXT   0x01 // 'x'      end of sequence
+#define OP_EFFECT 0x02 // 'eNN'    select effect/brightness NN
+#define OP_SET    0x03 // 'sYX'    set led YX to the selected effect
+#define OP_SETN   0x04 // 'sYX'... count, then count led indexes to set
+#define OP_ALL    0x05 // 'a'      set all leds to the selected effect
+#define OP_SHIFT  0x06 // 'pNN'    shift the matrix, NN as in animate()
+#define OP_WAIT   0x07 // 'wNNNN'  wait NNNN ticks, 0xffff stops
+#define OP_BLIT   0x08 // 'bRRRR'x16 show 16 row bitmaps (bit 15 = x 0) at full brightness,
+                     // stored as BLIT_SIZE bytes in l_port layout. The frame stays
+                     // until the script writes to the leds again. Compiled for
+                     // LED_PLANES, see script_to_code.py --planes.
+#define OP_ROTATE 0x09 // 'rNN'    as 'p' but the leds shifted out come back on the other side
+#define OP_SCROLL 0x0a // 'qNN'    as 'r', rotating the packed frame on display instead of
+                     // repacking it - cheap enough for a marquee step every tick
+#define OP_LINE   0x0b // 'lYXYX'  line between the two leds
+#define OP_RECT   0x0c // 'oYXYX'  rectangle outline, corners YX and YX
+#define OP_FILL   0x0d // 'fYXYX'  filled rectangle, also 'hYXN' row span to column N
+                     // and 'vYXN' column span to row N. All draw the selected effect.
+
+#define BLIT_SIZE (ROWS*LED_PLANES*2)
@@ -0,0 +1,251 @@
+// Compile-time version of script_to_code.py: turns the text script literal
+// (animaatio.h) into the opcodes of script.h while the firmware is compiled.
+// The output is byte for byte what script_to_code.py --planes LED_PLANES
+// generates. A malformed script stops the build with an error naming a
+// script_error_* function below, called from where the script went wrong.
+// Needs C++14.
+
+#ifndef SCRIPT_HPP
+#define SCRIPT_HPP
+
+#include <stdint.h>
+
+#include "../framebuffer.hpp"
+#include "led.h"
+#include "script.h"
+
+namespace script {
+
+// Never defined: a call in a constant expression is what fails the build.
+void script_error_unknown_command();
+void script_error_bad_hex_digit();
+void script_error_operand_cut_short();
+
+// A straight run of sets this long or longer compiles to OP_FILL.
+const uint8_t MIN_RUN = 4;
+
+// @brief Output that only counts, for sizing the code and the sequence table.
+struct Counter {
+  uint16_t size = 0;
+  uint8_t sequences = 1;
+  uint16_t last = 0; // where the last sequence starts
+  constexpr void put(uint8_t) { ++size; }
+  constexpr void next() {
+    ++sequences;
+    last = size;
+  }
+  // An empty sequence after the last 'x' is not one.
+  constexpr void end() {
+    if (sequences > 1 && last == size)
+      --sequences;
+  }
+};
+
+// @brief Output of Size bytes and Sequences sequence start offsets.
+template <uint16_t Size, uint8_t Sequences> struct Code {
+  uint8_t byte[Size];
+  uint16_t size;
+  uint16_t start[Sequences + 1];
+  uint8_t sequences;
+  constexpr Code() : byte{}, size(0), start{}, sequences(1) {}
+  constexpr void put(uint8_t b) { byte[size++] = b; }
+  constexpr void next() { start[sequences++] = size; }
+  constexpr void end() {}
+};
+
+// @brief The compiled script as it is stored: only the bytes, so the object
+// can stand in for the uint8_t array animate() reads.
+template <uint16_t Size> struct Image {
+  uint8_t byte[Size];
+};
+
+// @brief The sequence start offsets as they are stored.
+template <uint8_t Sequences> struct Starts {
+  uint16_t start[Sequences];
+};
+
+constexpr uint8_t hex_digit(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  script_error_bad_hex_digit();
+  return 0;
+}
+
+// @brief Returns the operand of digits hex digits at s[pos].
+constexpr uint16_t hex_operand(const char *s, uint16_t pos, uint8_t digits) {
+  uint16_t value = 0;
+  for (uint8_t i = 0; i < digits; ++i) {
+    if (s[pos + i] == 0) { // no reading past the end
+      script_error_operand_cut_short();
+      break;
+    }
+    value = (value << 4) | hex_digit(s[pos + i]);
+  }
+  return value;
+}
+
+// @brief Emits a run of sets: straight runs as fills, the rest as
+// OP_SET/OP_SETN. leds[] holds count led indexes.
+template <class Out>
+constexpr void sets(Out &out, const uint8_t *leds, uint8_t count) {
+  uint8_t rest[255] = {};
+  uint8_t rest_count = 0;
+  uint8_t i = 0;
+  while (i < count) {
+    uint8_t j = i + 1;
+    for (uint8_t k = 0; k < 2; ++k) { // along the row, then down the column
+      uint8_t step = k ? 0x10 : 0x01;
+      while (j < count && leds[j] == leds[j - 1] + step &&
+             (step == 0x01 ? leds[j - 1] & 0x0f : leds[j - 1] >> 4) != 0x0f)
+        ++j;
+      if (j - i > 1)
+        break;
+    }
+    if (j - i >= MIN_RUN) {
+      out.put(OP_FILL);
+      out.put(leds[i]);
+      out.put(leds[j - 1]);
+    } else {
+      for (; i < j; ++i)
+        rest[rest_count++] = leds[i];
+    }
+    i = j;
+  }
+  if (rest_count == 1) {
+    out.put(OP_SET);
+    out.put(rest[0]);
+  } else if (rest_count > 1) {
+    out.put(OP_SETN);
+    out.put(rest_count);
+    for (uint8_t k = 0; k < rest_count; ++k)
+      out.put(rest[k]);
+  }
+}
+
+// @brief Emits a blit frame of 16 row bitmaps at s[pos] in l_port layout,
+// through the Framebuffer the 1-bit renderers share.
+template <class Out> constexpr void blit(Out &out, const char *s, uint16_t pos) {
+  uint16_t rows[ROWS] = {};
+  for (uint8_t y = 0; y < ROWS; ++y)
+    rows[y] = hex_operand(s, pos + 4 * y, 4);
+  const Framebuffer<16, ROWS> frame = Framebuffer<16, ROWS>::from_rows(rows);
+  for (uint8_t y = 0; y < ROWS; ++y) {
+    uint16_t word = frame.port_word(y);
+    for (uint8_t p = 0; p < LED_PLANES; ++p) {
+      out.put(word & 0xff);
+      out.put(word >> 8);
+    }
+  }
+}
+
+// @brief Compiles the script s into out, see script.h for the commands.
+template <class Out> constexpr void compile(Out &out, const char *s) {
+  uint16_t pos = 0;
+  while (s[pos]) {
+    char command = s[pos++];
+    switch (command) {
+    case 's': { // consecutive sets share one opcode
+      uint8_t leds[255] = {};
+      uint8_t count = 0;
+      leds[count++] = hex_operand(s, pos, 2);
+      pos += 2;
+      while (s[pos] == 's' && count < 255) {
+        leds[count++] = hex_operand(s, pos + 1, 2);
+        pos += 3;
+      }
+      sets(out, leds, count);
+      break;
+    }
+    case 'e':
+    case 'p':
+    case 'r':
+    case 'q':
+      out.put(command == 'e'   ? OP_EFFECT
+              : command == 'p' ? OP_SHIFT
+              : command == 'r' ? OP_ROTATE
+                               : OP_SCROLL);
+      out.put(hex_operand(s, pos, 2));
+      pos += 2;
+      break;
+    case 'a':
+      out.put(OP_ALL);
+      break;
+    case 'h':
+    case 'v': { // row or column span from led YX to column or row N
+      uint8_t start = hex_operand(s, pos, 2);
+      uint8_t end = hex_operand(s, pos + 2, 1);
+      out.put(OP_FILL);
+      out.put(start);
+      out.put(command == 'h' ? (start & 0xf0) | end : (end << 4) | (start & 0x0f));
+      pos += 3;
+      break;
+    }
+    case 'l':
+    case 'o':
+    case 'f':
+      out.put(command == 'l' ? OP_LINE : command == 'o' ? OP_RECT : OP_FILL);
+      out.put(hex_operand(s, pos, 2));
+      out.put(hex_operand(s, pos + 2, 2));
+      pos += 4;
+      break;
+    case 'w': {
+      uint16_t wait = hex_operand(s, pos, 4);
+      out.put(OP_WAIT);
+      out.put(wait & 0xff);
+      out.put(wait >> 8);
+      pos += 4;
+      break;
+    }
+    case 'b':
+      out.put(OP_BLIT);
+      blit(out, s, pos);
+      pos += 4 * ROWS;
+      break;
+    case 'x':
+      out.put(OP_NEXT);
+      out.next();
+      break;
+    default:
+      script_error_unknown_command();
+    }
+  }
+  out.end();
+  out.put(OP_END);
+}
+
+// @brief Returns the code size and sequence count of the script s.
+constexpr Counter count(const char *s) {
+  Counter counter;
+  compile(counter, s);
+  return counter;
+}
+
+// @brief Returns the compiled script s, Size and Sequences from count(s).
+template <uint16_t Size, uint8_t Sequences>
+constexpr Image<Size> image(const char *s) {
+  Code<Size, Sequences> code;
+  compile(code, s);
+  Image<Size> result = {};
+  for (uint16_t i = 0; i < Size; ++i)
+    result.byte[i] = code.byte[i];
+  return result;
+}
+
+// @brief Returns where the sequences of the script s start.
+template <uint16_t Size, uint8_t Sequences>
+constexpr Starts<Sequences> starts(const char *s) {
+  Code<Size, Sequences> code;
+  compile(code, s);
+  Starts<Sequences> result = {};
+  for (uint8_t i = 0; i < Sequences; ++i)
+    result.start[i] = code.start[i];
+  return result;
+}
+
+} // namespace script
+
+#endif
@@ -0,0 +1,196 @@
+import re
+import sys
+
+from pins_to_code import PINS, read_pins, word_bit
+
+# Compiles text animation scripts (ref/animaatio.h, logo_vilkku.c) into the
+# binary opcodes animate() runs, see ref/script.h for the encoding.
+# Usage: python3 script_to_code.py [--planes N] SCRIPT [OUTPUT]
+#   --planes  LED_PLANES of the firmware build, sizes the blit frames (default 4)
+
+OP_END = 0x00
+OP_NEXT = 0x01
+OP_EFFECT = 0x02
+OP_SET = 0x03
+OP_SETN = 0x04
+OP_ALL = 0x05
+OP_SHIFT = 0x06
+OP_WAIT = 0x07
+OP_BLIT = 0x08
+OP_ROTATE = 0x09
+OP_SCROLL = 0x0a
+OP_LINE = 0x0b
+OP_RECT = 0x0c
+OP_FILL = 0x0d
+
+# A straight run of sets this long or longer compiles to OP_FILL.
+MIN_RUN = 4
+
+ROWS = 16
+# l_port word bit of each column, as X[] in led.c.
+with open(PINS) as f:
+  COLUMN_BIT = [word_bit(*pin) for pin in read_pins(f.read())[1]]
+
+BYTES_PER_LINE = 16
+
+
+class ScriptError(Exception):
+  pass
+
+
+# Returns the script text: the concatenated string literals of a C source
+# fragment with comments removed.
+def read_script(source):
+  source = re.sub(r"//[^\n]*", "", source)
+  source = re.sub(r"/\*.*?\*/", "", source, flags=re.S)
+  return "".join(re.findall(r'"([^"]*)"', source))
+
+
+def hex_operand(script, pos, digits):
+  text = script[pos:pos + digits]
+  if len(text) != digits or not re.fullmatch("[0-9a-fA-F]+", text):
+    raise ScriptError("bad operand '{}' at {}".format(text, pos))
+  return int(text, 16)
+
+
+# Returns a frame of 16 row bitmaps (bit 15 = x 0) as l_port bytes: per row
+# and phase one little endian word, bit COLUMN_BIT[x] low when led x is lit.
+def blit_frame(rows, planes):
+  code = []
+  for row in rows:
+    word = 0xffff
+    for x in range(ROWS):
+      if row & (0x8000 >> x):
+        word &= ~(1 << COLUMN_BIT[x])
+    code += [word & 0xff, word >> 8] * planes
+  return code
+
+
+# Returns the code setting leds: straight runs, in the order listed, as fills
+# and the rest as OP_SET/OP_SETN.
+def compile_sets(leds):
+  code = []
+  rest = []
+  i = 0
+  while i < len(leds):
+    j = i + 1
+    for step in (0x01, 0x10):
+      while (j < len(leds) and leds[j] == leds[j - 1] + step and
+             (leds[j - 1] & 0x0f if step == 0x01 else leds[j - 1] >> 4) != 0x0f):
+        j += 1
+      if j - i > 1:
+        break
+    if j - i >= MIN_RUN:
+      code += [OP_FILL, leds[i], leds[j - 1]]
+    else:
+      rest += leds[i:j]
+    i = j
+  if len(rest) == 1:
+    code += [OP_SET] + rest
+  elif rest:
+    code += [OP_SETN, len(rest)] + rest
+  return code
+
+
+# Returns the code, the number of blit frames in it and the offsets where the
+# sequences start. An empty sequence after the last 'x' is not one.
+def compile_script(script, planes=4):
+  code = []
+  blits = 0
+  starts = [0]
+  pos = 0
+  while pos < len(script):
+    command = script[pos]
+    pos += 1
+    if command == "s":
+      # Consecutive sets share one opcode.
+      leds = [hex_operand(script, pos, 2)]
+      pos += 2
+      while pos < len(script) and script[pos] == "s" and len(leds) < 255:
+        leds.append(hex_operand(script, pos + 1, 2))
+        pos += 3
+      code += compile_sets(leds)
+    elif command == "e":
+      code += [OP_EFFECT, hex_operand(script, pos, 2)]
+      pos += 2
+    elif command == "a":
+      code += [OP_ALL]
+    elif command in "prq":
+      code += [{"p": OP_SHIFT, "r": OP_ROTATE, "q": OP_SCROLL}[command],
+               hex_operand(script, pos, 2)]
+      pos += 2
+    elif command in "hv":
+      # Row or column span from led YX to column or row N: 'hYXN', 'vYXN'.
+      start = hex_operand(script, pos, 2)
+      end = hex_operand(script, pos + 2, 1)
+      end = (start & 0xf0) | end if command == "h" else (end << 4) | (start & 0x0f)
+      code += [OP_FILL, start, end]
+      pos += 3
+    elif command in "lof":
+      code += [{"l": OP_LINE, "o": OP_RECT, "f": OP_FILL}[command],
+               hex_operand(script, pos, 2), hex_operand(script, pos + 2, 2)]
+      pos += 4
+    elif command == "w":
+      wait = hex_operand(script, pos, 4)
+      code += [OP_WAIT, wait & 0xff, wait >> 8]
+      pos += 4
+    elif command == "b":
+      code += [OP_BLIT] + blit_frame([hex_operand(script, pos + 4 * y, 4) for y in range(ROWS)],
+                                    planes)
+      blits += 1
+      pos += 4 * ROWS
+    elif command == "x":
+      code += [OP_NEXT]
+      starts.append(len(code))
+    else:
+      raise ScriptError("unknown command '{}' at {}".format(command, pos - 1))
+  if len(starts) > 1 and starts[-1] == len(code):
+    starts.pop()
+  return code + [OP_END], blits, starts
+
+
+# Blit frames only fit the LED_PLANES they were compiled for, the guard makes a
+# mismatched build fail instead of showing garbage. The sequence table goes in
+# macros for animation.c, the header itself is included in the code array.
+def to_c(code, name, starts, planes=None):
+  lines = ["// Generated by script_to_code.py from {}, do not edit.".format(name)]
+  if planes is not None:
+    lines += ["#if LED_PLANES!={}".format(planes),
+              "#error {} was compiled for LED_PLANES {}".format(name, planes),
+              "#endif"]
+  for i in range(0, len(code), BYTES_PER_LINE):
+    lines.append(",".join("0x{:02x}".format(b) for b in code[i:i + BYTES_PER_LINE]) + ",")
+  lines.append("#define ANIMATION_SEQUENCES {}".format(len(starts)))
+  starts = ["0x{:04x}".format(start) for start in starts]
+  per_line = BYTES_PER_LINE // 2
+  lines.append("#define ANIMATION_START " + " \\\r\n  ".join(
+      ",".join(starts[i:i + per_line]) for i in range(0, len(starts), per_line)))
+  return "\r\n".join(lines) + "\r\n"
+
+
+def main():
+  args = sys.argv[1:]
+  planes = 4
+  if args[:1] == ["--planes"] and len(args) > 1 and args[1] in ("4", "6", "8"):
+    planes = int(args[1])
+    args = args[2:]
+  if len(args) not in (1, 2):
+    sys.exit("usage: script_to_code.py [--planes 4|6|8] SCRIPT [OUTPUT]")
+  with open(args[0]) as f:
+    script = read_script(f.read())
+  try:
+    code, blits, starts = compile_script(script, planes)
+  except ScriptError as e:
+    sys.exit("{}: {}".format(args[0], e))
+  text = to_c(code, args[0].split("/")[-1], starts, planes if blits else None)
+  if len(args) == 2:
+    with open(args[1], "w", newline="") as f:
+      f.write(text)
+  else:
+    sys.stdout.write(text)
+  print("{}: {} script bytes -> {} code bytes, {} sequences".format(
+      args[0], len(script), len(code), len(starts)), file=sys.stderr)
+
+
+if __name__ == "__main__":
+  main()
@@ -0,0 +1,144 @@
+import re
+import sys
+
+# Checks that the branches of the inline asm in a preprocessed C file reach
+# their labels, the check avr-as would make: br* within -64 - +63 words,
+# rjmp and rcall within -2048 - +2047. Instructions are counted by size, 2
+# words for lds, sts, call and jmp, 1 for the rest. The compiler may load
+# register operands between two asm statements of a function, every such
+# operand is counted as 2 words there.
+# Usage: cc -E -P [flags] FILE.c | python3 asm_reach.py [NAME]
+
+BRANCH_REACH = 64
+JUMP_REACH = 2048
+LONG = {"lds", "sts", "call", "jmp"}
+IMMEDIATE = set("IMnisKLNOPGJ")
+KEYWORDS = {"if", "for", "while", "switch", "do"}
+STRING = re.compile(r'"(?:[^"\\]|\\.)*"')
+
+
+class AsmError(Exception):
+  pass
+
+
+# Returns the text of the C string literals at the start of s and where they end.
+def read_strings(s, pos):
+  text = []
+  while True:
+    m = re.compile(r'\s*' + STRING.pattern).match(s, pos)
+    if not m:
+      return "".join(text), pos
+    text.append(m.group(0).strip()[1:-1].replace("\\n", "\n").replace("\\t", "\t").replace('\\"', '"'))
+    pos = m.end()
+
+
+# Returns the end of the parenthesized expression that starts at s[pos] == "(".
+def skip_parens(s, pos):
+  depth = 0
+  i = pos
+  while i < len(s):
+    if s[i] == '"':
+      i = STRING.match(s, i).end()
+      continue
+    if s[i] == "(":
+      depth += 1
+    elif s[i] == ")":
+      depth -= 1
+      if depth == 0:
+        return i + 1
+    i += 1
+  raise AsmError("unbalanced parentheses")
+
+
+# Returns the asm statements of each function as (function, [(template,
+# register operands)]), the functions in file order.
+def read_asm(s):
+  functions = []
+  for m in re.finditer(r"\b(?:asm|__asm__)\s*(?:volatile|__volatile__)?\s*\(", s):
+    end = skip_parens(s, m.end() - 1)
+    template, pos = read_strings(s, m.end())
+    operands = s[pos:end]
+    constraints = re.findall(r'"([^"]*)"\s*\(', operands)
+    registers = sum(1 for c in constraints if not set(c.lstrip("=+&")) <= IMMEDIATE)
+    # the function is the last "name(...)" followed by "{" at the top level before
+    head = s[:m.start()]
+    f = re.findall(r"^(?:[A-Za-z_][\w ]*?)?\b(\w+)\s*\([^;{]*\)\s*\{", head, re.M)
+    f = [n for n in f if n not in KEYWORDS]
+    name = f[-1] if f else "?"
+    if not functions or functions[-1][0] != name:
+      functions.append((name, []))
+    functions[-1][1].append((template, registers))
+  return functions
+
+
+# Returns the branch distance problems of one function's asm statements.
+def check(name, statements):
+  labels = {}
+  numbered = []  # (number, address) of the numeric local labels
+  branches = []  # (mnemonic, target, address, line)
+  address = 0
+  for template, registers in statements:
+    address += 2 * registers
+    for line in template.split("\n"):
+      line = line.split(";")[0].strip()
+      while True:
+        m = re.match(r"(\w+):\s*", line)
+        if not m:
+          break
+        if m.group(1).isdigit():
+          numbered.append((m.group(1), address))
+        elif m.group(1) in labels:
+          raise AsmError("{}: label {} defined twice".format(name, m.group(1)))
+        else:
+          labels[m.group(1)] = address
+        line = line[m.end():]
+      if not line:
+        continue
+      mnemonic = line.split()[0].lower()
+      if mnemonic.startswith("br") or mnemonic in ("rjmp", "rcall"):
+        target = line.split(",")[-1].split()[-1]
+        branches.append((mnemonic, target, address, line))
+      address += 2 if mnemonic in LONG else 1
+  problems = []
+  farthest = 0
+  for mnemonic, target, address, line in branches:
+    m = re.fullmatch(r"(\d+)([bf])", target)
+    if m:
+      found = [a for n, a in numbered if n == m.group(1) and
+               (a <= address if m.group(2) == "b" else a > address)]
+      if not found:
+        raise AsmError("{}: no label for '{}'".format(name, line))
+      to = found[-1] if m.group(2) == "b" else found[0]
+    elif target in labels:
+      to = labels[target]
+    else:
+      raise AsmError("{}: no label for '{}'".format(name, line))
+    distance = to - (address + 1)
+    reach = JUMP_REACH if mnemonic in ("rjmp", "rcall") else BRANCH_REACH
+    if mnemonic not in ("rjmp", "rcall"):
+      farthest = max(farthest, abs(distance))
+    if not -reach <= distance < reach:
+      problems.append("{}: '{}' is {} words from its label".format(name, line, distance))
+  return problems, len(branches), farthest
+
+
+def main():
+  args = sys.argv[1:]
+  if len(args) > 1:
+    sys.exit("usage: asm_reach.py [NAME] < preprocessed.c")
+  title = args[0] if args else "stdin"
+  try:
+    problems = []
+    for name, statements in read_asm(sys.stdin.read()):
+      p, count, farthest = check(name, statements)
+      if count:
+        print("{} {}(): {} branches, farthest br* {} words".format(title, name, count, farthest))
+      problems += p
+  except AsmError as e:
+    sys.exit("{}: {}".format(title, e))
+  if problems:
+    sys.exit("\n".join("{} {}".format(title, p) for p in problems))
+
+
+if __name__ == "__main__":
+  main()
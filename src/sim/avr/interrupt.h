@@ -0,0 +1,20 @@
+// Host simulator stand-in for <avr/interrupt.h>. Interrupt vectors become
+// plain functions that sim_step() calls; the global enable lives in SREG.
+
+#ifndef SIM_AVR_INTERRUPT_H
+#define SIM_AVR_INTERRUPT_H
+
+#include <avr/io.h>
+
+#define ISR_NAKED
+#define ISR(vector,...) void vector(void)
+
+#define TIMER1_COMPA_vect sim_timer1_compa_vect
+#define TIMER1_OVF_vect   sim_timer1_ovf_vect
+#define TIMER0_COMP_vect  sim_timer0_comp_vect
+#define INT0_vect         sim_int0_vect
+
+#define sei() (SREG|=0x80)
+#define cli() (SREG&=~0x80)
+
+#endif
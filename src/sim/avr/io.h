@@ -0,0 +1,126 @@
+// Host simulator stand-in for <avr/io.h> (ATmega162 register subset).
+// Every register lives in sim_io[] at its data space address, so
+// _SFR_MEM8(address) style accesses work the same as on the target.
+
+#ifndef SIM_AVR_IO_H
+#define SIM_AVR_IO_H
+
+#include <stdint.h>
+
+#include "sim.h"
+
+#define __SFR_OFFSET 0x20
+
+#define _SFR_MEM8(addr)  (sim_io[(addr)])
+#define _SFR_MEM16(addr) (*(volatile uint16_t *)&sim_io[(addr)])
+#define _SFR_IO8(addr)   _SFR_MEM8((addr)+__SFR_OFFSET)
+#define _SFR_IO16(addr)  _SFR_MEM16((addr)+__SFR_OFFSET)
+
+// sfr##_ADDR keeps these usable in static initializers on the host
+#define _SFR_MEM_ADDR(sfr) (sfr##_ADDR)
+#define _SFR_IO_ADDR(sfr)  (sfr##_ADDR-__SFR_OFFSET)
+
+#define PINE_ADDR   0x25
+#define DDRE_ADDR   0x26
+#define PORTE_ADDR  0x27
+#define PIND_ADDR   0x30
+#define DDRD_ADDR   0x31
+#define PORTD_ADDR  0x32
+#define PINC_ADDR   0x33
+#define DDRC_ADDR   0x34
+#define PORTC_ADDR  0x35
+#define PINB_ADDR   0x36
+#define DDRB_ADDR   0x37
+#define PORTB_ADDR  0x38
+#define PINA_ADDR   0x39
+#define DDRA_ADDR   0x3A
+#define PORTA_ADDR  0x3B
+#define OCR1BL_ADDR 0x48
+#define OCR1BH_ADDR 0x49
+#define OCR1AL_ADDR 0x4A
+#define OCR1AH_ADDR 0x4B
+#define TCNT1L_ADDR 0x4C
+#define TCNT1H_ADDR 0x4D
+#define TCCR1B_ADDR 0x4E
+#define TCCR1A_ADDR 0x4F
+#define OCR0_ADDR   0x51
+#define TCNT0_ADDR  0x52
+#define TCCR0_ADDR  0x53
+#define MCUCSR_ADDR 0x54
+#define MCUCR_ADDR  0x55
+#define EMCUCR_ADDR 0x56
+#define TIFR_ADDR   0x58
+#define TIMSK_ADDR  0x59
+#define GIFR_ADDR   0x5A
+#define GICR_ADDR   0x5B
+#define SREG_ADDR   0x5F
+
+#define OCR1A_ADDR  OCR1AL_ADDR
+#define OCR1B_ADDR  OCR1BL_ADDR
+#define TCNT1_ADDR  TCNT1L_ADDR
+
+#define PINE   _SFR_MEM8(PINE_ADDR)
+#define DDRE   _SFR_MEM8(DDRE_ADDR)
+#define PORTE  _SFR_MEM8(PORTE_ADDR)
+#define PIND   _SFR_MEM8(PIND_ADDR)
+#define DDRD   _SFR_MEM8(DDRD_ADDR)
+#define PORTD  _SFR_MEM8(PORTD_ADDR)
+#define PINC   _SFR_MEM8(PINC_ADDR)
+#define DDRC   _SFR_MEM8(DDRC_ADDR)
+#define PORTC  _SFR_MEM8(PORTC_ADDR)
+#define PINB   _SFR_MEM8(PINB_ADDR)
+#define DDRB   _SFR_MEM8(DDRB_ADDR)
+#define PORTB  _SFR_MEM8(PORTB_ADDR)
+#define PINA   _SFR_MEM8(PINA_ADDR)
+#define DDRA   _SFR_MEM8(DDRA_ADDR)
+#define PORTA  _SFR_MEM8(PORTA_ADDR)
+#define OCR1A  _SFR_MEM16(OCR1A_ADDR)
+#define OCR1AL _SFR_MEM8(OCR1AL_ADDR)
+#define OCR1AH _SFR_MEM8(OCR1AH_ADDR)
+#define OCR1B  _SFR_MEM16(OCR1B_ADDR)
+#define TCNT1  _SFR_MEM16(TCNT1_ADDR)
+#define TCCR1A _SFR_MEM8(TCCR1A_ADDR)
+#define TCCR1B _SFR_MEM8(TCCR1B_ADDR)
+#define OCR0   _SFR_MEM8(OCR0_ADDR)
+#define TCNT0  _SFR_MEM8(TCNT0_ADDR)
+#define TCCR0  _SFR_MEM8(TCCR0_ADDR)
+#define MCUCSR _SFR_MEM8(MCUCSR_ADDR)
+#define MCUCR  _SFR_MEM8(MCUCR_ADDR)
+#define EMCUCR _SFR_MEM8(EMCUCR_ADDR)
+#define TIFR   _SFR_MEM8(TIFR_ADDR)
+#define TIMSK  _SFR_MEM8(TIMSK_ADDR)
+#define GIFR   _SFR_MEM8(GIFR_ADDR)
+#define GICR   _SFR_MEM8(GICR_ADDR)
+#define SREG   _SFR_MEM8(SREG_ADDR)
+
+// bit names used by the firmware
+#define PA0 0
+#define PA1 1
+#define PA2 2
+#define PA3 3
+#define PA4 4
+#define PA5 5
+#define PA6 6
+#define PA7 7
+#define PD0 0
+#define PD1 1
+#define PD2 2
+#define PD3 3
+#define PD4 4
+#define PD5 5
+#define PD6 6
+#define PD7 7
+#define CS10 0
+#define CS11 1
+#define CS12 2
+#define WGM12 3
+#define CS00 0
+#define CS01 1
+#define CS02 2
+#define WGM01 3
+#define TOIE1 7
+#define OCIE1A 6
+#define OCIE0 0
+#define OCF1A 6
+
+#endif
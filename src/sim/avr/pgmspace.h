@@ -0,0 +1,22 @@
+// Host simulator stand-in for <avr/pgmspace.h>. Flash and RAM share one
+// address space on the host, so the readers are plain loads.
+
+#ifndef SIM_AVR_PGMSPACE_H
+#define SIM_AVR_PGMSPACE_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PGM_P const char *
+
+#define pgm_read_byte_near(p)  (*(const uint8_t *)(p))
+#define pgm_read_word_near(p)  (*(const uint16_t *)(p))
+#define pgm_read_dword_near(p) (*(const uint32_t *)(p))
+#define pgm_read_byte(p)       pgm_read_byte_near(p)
+#define pgm_read_word(p)       pgm_read_word_near(p)
+#define pgm_read_dword(p)      pgm_read_dword_near(p)
+
+#define memcpy_P(dst,src,n) memcpy((dst),(src),(n))
+
+#endif
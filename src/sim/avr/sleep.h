@@ -0,0 +1,17 @@
+// Host simulator stand-in for <avr/sleep.h>. Sleeping lets simulated time
+// run to the next interrupt.
+
+#ifndef SIM_AVR_SLEEP_H
+#define SIM_AVR_SLEEP_H
+
+#include "sim.h"
+
+#define set_sleep_mode(mode)
+#define sleep_enable()
+#define sleep_disable()
+#define sleep_cpu()  sim_step()
+#define sleep_mode() sim_step()
+
+#define SLEEP_MODE_IDLE 0
+
+#endif
@@ -0,0 +1,183 @@
+// Host time of the animation hot paths of ledivilkku.c: animate() running
+// each opcode once, the auto-fade pass with l2led(), matrix(), and the clock
+// face of face.c that only simulate -c draws.
+//
+// usage: bench_animate [-n iterations] [-o results]
+//   -o  append the times to results, see sim_bench()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "led.h"
+#include "script.h"
+#include "face.h"
+
+// from ledivilkku.c
+extern const uint8_t *a_ptr;
+extern uint16_t a_w;
+extern uint8_t a_e;
+extern uint8_t a_blit;
+void setup(void);
+void tick(void);
+void animate(void);
+void matrix(void);
+void animate_track(uint8_t i);
+
+// An opcode with its operands, run by animate() up to the wait after it.
+struct op {
+const char *name;
+uint8_t size;
+uint8_t code[1+BLIT_SIZE];
+};
+
+static const struct op ops[]={
+   {"OP_WAIT",0,{0}}, // the wait alone, in all of the others too
+   {"OP_EFFECT",2,{OP_EFFECT,0x0f}},
+   {"OP_SET",2,{OP_SET,0x77}},
+   {"OP_SETN",9,{OP_SETN,7,0x00,0x11,0x22,0x33,0x44,0x55,0x66}},
+   {"OP_ALL",1,{OP_ALL}},
+   {"OP_SHIFT",2,{OP_SHIFT,0x11}},
+   {"OP_ROTATE",2,{OP_ROTATE,0x11}},
+   {"OP_SCROLL",2,{OP_SCROLL,0x11}},
+   {"OP_LINE",3,{OP_LINE,0x00,0xfa}},
+   {"OP_RECT",3,{OP_RECT,0x11,0xee}},
+   {"OP_FILL",3,{OP_FILL,0x11,0xee}},
+   {"OP_BLIT",1+BLIT_SIZE,{OP_BLIT}}, // all anodes low, every led lit
+   };
+
+static uint8_t code[sizeof(ops[0].code)+3];
+
+
+
+// runs the opcode in code[] n times, each time from the start
+static double time_op(uint32_t n)
+{
+uint64_t start=sim_nanos();
+for (uint32_t i=0;i<n;i++)
+   {
+   a_ptr=code;
+   a_w=0;
+   animate();
+   }
+return((double)(sim_nanos()-start)/n);
+}
+
+
+
+// the fade pass over every lit led, bouncing so that none finishes
+static double time_fade(uint32_t n,uint16_t leds)
+{
+uint64_t start;
+memset(l,0,ROWS*ROWS);
+for (uint16_t i=0;i<leds;i++)
+   {
+   l[i]=0x78;
+   animate_track(i);
+   }
+a_blit=0;
+led_tick=0;
+start=sim_nanos();
+for (uint32_t i=0;i<n;i++)
+   {
+   a_w=0x1000; // no opcodes
+   animate();
+   }
+return((double)(sim_nanos()-start)/n);
+}
+
+
+
+static double time_matrix(uint32_t n)
+{
+uint64_t start=sim_nanos();
+for (uint32_t i=0;i<n;i++) matrix();
+return((double)(sim_nanos()-start)/n);
+}
+
+
+
+// a redraw a second, as a clock would, with the l2led() that shows it
+static double time_face(uint32_t n)
+{
+uint64_t start=sim_nanos();
+for (uint32_t i=0;i<n;i++)
+   {
+   face_draw(i/3600%12,i/60%60,i%60);
+   l2led();
+   }
+return((double)(sim_nanos()-start)/n);
+}
+
+
+
+static double time_tick(uint32_t n)
+{
+uint64_t start=sim_nanos();
+for (uint32_t i=0;i<n;i++) tick();
+return((double)(sim_nanos()-start)/n);
+}
+
+
+
+static void report(const char *name,double ns)
+{
+printf("%-24s %8.1f ns\n",name,ns);
+sim_bench(name,ns);
+}
+
+
+
+int main(int argc, char **argv)
+{
+uint32_t n=50000;
+int opt;
+char name[32];
+
+while ((opt=getopt(argc,argv,"n:o:"))!=-1)
+   {
+   switch (opt)
+      {
+	  case 'n':
+	     n=strtoul(optarg,NULL,0);
+		 break;
+	  case 'o':
+	     if (!sim_bench_open(optarg)) return(1);
+		 break;
+	  default:
+	     fprintf(stderr,"usage: %s [-n iterations] [-o results]\n",argv[0]);
+		 return(1);
+	  }
+   }
+
+sim_reset();
+setup();
+printf("%d planes, host time per call:\n",LED_PLANES);
+
+// every 4th tick runs the fade pass, the opcodes are timed without it
+led_tick=1;
+for (uint8_t k=0;k<sizeof(ops)/sizeof(ops[0]);k++)
+   {
+   memcpy(code,ops[k].code,ops[k].size);
+   code[ops[k].size]=OP_WAIT;
+   code[ops[k].size+1]=1;
+   code[ops[k].size+2]=0;
+   memset(l,0x0f,ROWS*ROWS);
+   a_e=0x0f;
+   a_blit=0;
+   snprintf(name,sizeof(name),"animate.%s",ops[k].name);
+   report(name,sim_best(time_op(n)));
+   }
+
+report("animate.fade16",sim_best(time_fade(n,16)));
+report("animate.fade256",sim_best(time_fade(n/4,ROWS*ROWS)));
+
+// matrix() waits 7 ticks of simulated scanning, timed on their own as tick
+srand(1);
+report("matrix",sim_best(time_matrix(n/100)));
+report("tick",sim_best(time_tick(n/10)));
+report("face_draw",sim_best(time_face(n/10)));
+return(0);
+}
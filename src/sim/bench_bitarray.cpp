@@ -0,0 +1,241 @@
+// Compares BitArray (../bit_array.hpp) with the byte-wise version it
+// replaced, both for identical bits and for host time per operation on a
+// 16x16 frame. BitArray runs with bytes (as on AVR) and with 64-bit words.
+//
+// usage: bench_bitarray [-n iterations] [-o results]
+//   -o  append the times to results, see sim_bench()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+extern "C" {
+#include "sim.h"
+}
+#include "../bit_array.hpp"
+
+const uint16_t FRAME_BITS = 256;
+
+// BitArray as it was before the storage word, with its private helpers made
+// public for the comparison.
+template <uint16_t Bits, uint16_t BYTE_LENGTH = (Bits - 1) / 8 + 1>
+class ByteBitArray {
+  using bit_array_t = uint8_t;
+  using index_t = uint8_t;
+  using this_type = ByteBitArray<Bits, BYTE_LENGTH>;
+
+public:
+  static const uint8_t BITS_IN_BYTE = 8;
+
+  void shift_left(index_t shift) {
+    if (shift > 0) {
+      for (index_t i = 0; i < shift / BITS_IN_BYTE; ++i)
+        shift_left_impl(BITS_IN_BYTE);
+      shift_left_impl(shift % BITS_IN_BYTE);
+    }
+  }
+
+  void shift_right(index_t shift) {
+    if (shift > 0) {
+      for (index_t i = 0; i < shift / BITS_IN_BYTE; ++i)
+        shift_right_impl(BITS_IN_BYTE);
+      shift_right_impl(shift % BITS_IN_BYTE);
+    }
+  }
+
+  bit_array_t least_signf_byte_mask() const {
+    auto rem = Bits % BITS_IN_BYTE;
+    if (rem == 0)
+      return 0xFF;
+    return 0xFF << (BITS_IN_BYTE - rem);
+  }
+
+  void shift_left_impl(index_t sl) {
+    for (index_t i = 0; i < BYTE_LENGTH - 1; ++i) {
+      bit_array[i] <<= sl;
+      bit_array[i] |= bit_array[i + 1] >> (BITS_IN_BYTE - sl);
+    }
+    bit_array[BYTE_LENGTH - 1] <<= sl;
+  }
+
+  void shift_right_impl(index_t sr) {
+    for (index_t i = BYTE_LENGTH - 1; i > 0; --i) {
+      bit_array[i] >>= sr;
+      bit_array[i] |= bit_array[i - 1] << (BITS_IN_BYTE - sr);
+    }
+    bit_array[0] >>= sr;
+    bit_array[BYTE_LENGTH - 1] &= least_signf_byte_mask();
+  }
+
+  void not_me() {
+    for (index_t i = 0; i < BYTE_LENGTH - 1; ++i)
+      bit_array[i] = ~bit_array[i];
+    bit_array[BYTE_LENGTH - 1] =
+        (~bit_array[BYTE_LENGTH - 1]) & least_signf_byte_mask();
+  }
+
+  void and_with(const this_type &other) {
+    for (index_t i = 0; i < BYTE_LENGTH; ++i)
+      bit_array[i] &= other.bit_array[i];
+  }
+
+  void xor_with(const this_type &other) {
+    for (index_t i = 0; i < BYTE_LENGTH; ++i)
+      bit_array[i] ^= other.bit_array[i];
+  }
+
+  bit_array_t bit_array[BYTE_LENGTH];
+};
+
+using Legacy = ByteBitArray<FRAME_BITS - 1>; // 255 bits, its index_t is 8-bit
+using Bytes = BitArray<FRAME_BITS - 1, uint8_t>;
+using Words = BitArray<FRAME_BITS - 1, uint64_t>;
+
+// Built at compile time: a row of 16 lit on the first line.
+constexpr Words top_row() {
+  Words w;
+  for (uint8_t i = 0; i < 16; ++i)
+    w.set(i);
+  return w;
+}
+static_assert(top_row().count() == 16, "constexpr BitArray");
+static_assert((top_row() >> 20).find_first() == 20, "constexpr BitArray");
+
+template <class A> static void fill(A &a, const Legacy &from) {
+  for (uint16_t i = 0; i < FRAME_BITS - 1; ++i)
+    a.set(i, from.bit_array[i / 8] & (0x80 >> (i % 8)));
+}
+
+template <class A> static bool same(const A &a, const Legacy &b) {
+  for (uint16_t i = 0; i < FRAME_BITS - 1; ++i)
+    if (a.test(i) != bool(b.bit_array[i / 8] & (0x80 >> (i % 8))))
+      return false;
+  return true;
+}
+
+static void random_frame(Legacy &a) {
+  for (uint8_t i = 0; i < sizeof(a.bit_array); ++i)
+    a.bit_array[i] = rand();
+  a.bit_array[sizeof(a.bit_array) - 1] &= a.least_signf_byte_mask();
+}
+
+template <class A> static bool check(const char *name) {
+  for (uint16_t n = 0; n < 2000; ++n) {
+    Legacy a, b;
+    A x, y;
+    random_frame(a);
+    random_frame(b);
+    fill(x, a);
+    fill(y, b);
+    uint8_t shift = rand() % 256;
+    switch (n % 5) {
+    case 0:
+      a.shift_left(shift);
+      x <<= shift;
+      break;
+    case 1:
+      a.shift_right(shift);
+      x >>= shift;
+      break;
+    case 2:
+      a.and_with(b);
+      x &= y;
+      break;
+    case 3:
+      a.xor_with(b);
+      x ^= y;
+      break;
+    case 4:
+      a.not_me();
+      x = ~x;
+      break;
+    }
+    if (!same(x, a)) {
+      printf("bitarray: %s differs from the byte-wise version, case %u\n", name, n);
+      return false;
+    }
+  }
+  return true;
+}
+
+// The operations timed, for both classes.
+static void set_bit(Legacy &a, uint8_t i) { a.bit_array[i / 8] |= 0x80 >> (i % 8); }
+static void and_with(Legacy &a, const Legacy &b) { a.and_with(b); }
+static void xor_with(Legacy &a, const Legacy &b) { a.xor_with(b); }
+static void invert(Legacy &a) { a.not_me(); }
+static uint8_t first_word(const Legacy &a) { return a.bit_array[0]; }
+
+template <class A> static void set_bit(A &a, uint8_t i) { a.set(i); }
+template <class A> static void and_with(A &a, const A &b) { a &= b; }
+template <class A> static void xor_with(A &a, const A &b) { a ^= b; }
+template <class A> static void invert(A &a) { a = ~a; }
+template <class A> static uint8_t first_word(const A &a) { return a[0]; }
+
+// Host time per call of op, which sets a bit every time so that the compiler
+// cannot hoist the work out of the loop. The fastest of SIM_BENCH_REPEATS runs.
+template <class A, class Op> static double time_ns(A &a, Op op, uint32_t n) {
+  double best = 1e30;
+  for (uint8_t r = 0; r < SIM_BENCH_REPEATS; ++r) {
+    uint64_t start = sim_nanos();
+    for (uint32_t i = 0; i < n; ++i) {
+      set_bit(a, i & 0x7f);
+      op(a);
+    }
+    double t = double(sim_nanos() - start) / n;
+    if (t < best)
+      best = t;
+  }
+  return best;
+}
+
+// @brief Records the time of operation op of the array kind as
+// bitarray.<kind>.<op>.
+static void record(const char *kind, const char *op, double ns) {
+  char name[64];
+  snprintf(name, sizeof(name), "bitarray.%s.%s", kind, op);
+  sim_bench(name, ns);
+}
+
+// kind names the array in the results file.
+template <class A> static void bench(const char *name, const char *kind, uint32_t n) {
+  A a = {}, b = {};
+  set_bit(b, 100);
+  double t_row = time_ns(a, [](A &x) { x.shift_right(16); }, n);
+  double t_odd = time_ns(a, [](A &x) { x.shift_left(37); }, n);
+  double t_and = time_ns(a, [&b](A &x) { and_with(x, b); }, n);
+  double t_xor = time_ns(a, [&b](A &x) { xor_with(x, b); }, n);
+  double t_not = time_ns(a, [](A &x) { invert(x); }, n);
+  volatile uint8_t sink = first_word(a);
+  (void)sink;
+  printf("%-14s shift 16 %6.1f ns, shift 37 %6.1f ns, and %6.1f ns, xor %6.1f ns, not %6.1f ns\n",
+         name, t_row, t_odd, t_and, t_xor, t_not);
+  record(kind, "shift16", t_row);
+  record(kind, "shift37", t_odd);
+  record(kind, "and", t_and);
+  record(kind, "xor", t_xor);
+  record(kind, "not", t_not);
+}
+
+int main(int argc, char **argv) {
+  uint32_t n = 500000;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:o:")) != -1) {
+    if (opt == 'n') {
+      n = strtoul(optarg, NULL, 0);
+    } else if (opt == 'o') {
+      if (!sim_bench_open(optarg))
+        return 1;
+    } else {
+      fprintf(stderr, "usage: %s [-n iterations] [-o results]\n", argv[0]);
+      return 1;
+    }
+  }
+  srand(1);
+  if (!check<Bytes>("bytes") || !check<Words>("64-bit words"))
+    return 1;
+  printf("BitArray of %u bits, host time per operation:\n", FRAME_BITS - 1);
+  bench<Legacy>("byte-wise", "bytewise", n);
+  bench<Bytes>("bytes", "bytes", n);
+  bench<Words>("64-bit words", "words64", n);
+  return 0;
+}
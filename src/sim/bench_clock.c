@@ -0,0 +1,162 @@
+// Host time of the clock renderers in ../main: real_clock.c's digital clock,
+// its port images and row output (what set_column() of main.c was meant to
+// do), and clock.c's digital clock, analog face and lines.
+//
+// usage: bench_clock [-n iterations] [-o results]
+//   -o  append the times to results, see sim_bench()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "sim.h"
+
+// from real_clock.c
+extern uint16_t screen[16];
+void displayDigitalClockOnScreen(void);
+void screen_to_ports(void);
+void show_row(uint8_t row);
+void sim_timer1_compa_vect(void); // a second
+void sim_timer0_comp_vect(void);  // the next row
+
+// from clock.c, renamed where it clashes with real_clock.c
+extern uint16_t analog_screen[16];
+extern uint16_t minutes,seconds;
+void analog_displayDigitalClockOnScreen(void);
+void displayAnalogClockOnScreen(void);
+void drawLine(int8_t x1, int8_t y1, int8_t x2, int8_t y2);
+
+static volatile uint16_t sink;
+
+
+
+// one second of real_clock.c: the time interrupt and the redraw
+static double time_digital(uint32_t n)
+{
+uint64_t start=sim_nanos();
+for (uint32_t i=0;i<n;i++)
+   {
+   sim_timer1_compa_vect();
+   displayDigitalClockOnScreen();
+   }
+return((double)(sim_nanos()-start)/n);
+}
+
+
+
+static double time_ports(uint32_t n)
+{
+uint64_t start=sim_nanos();
+for (uint32_t i=0;i<n;i++)
+   {
+   screen[i&15]^=i; // keep the compiler from hoisting the work out
+   screen_to_ports();
+   }
+return((double)(sim_nanos()-start)/n);
+}
+
+
+
+static double time_show_row(uint32_t n)
+{
+uint64_t start=sim_nanos();
+for (uint32_t i=0;i<n;i++) show_row(i&15);
+return((double)(sim_nanos()-start)/n);
+}
+
+
+
+static double time_scan(uint32_t n)
+{
+uint64_t start=sim_nanos();
+for (uint32_t i=0;i<n;i++) sim_timer0_comp_vect();
+return((double)(sim_nanos()-start)/n);
+}
+
+
+
+// clock.c's digital clock keeps only the minutes of the hour in minutes
+static double time_analog_digital(uint32_t n)
+{
+uint64_t start=sim_nanos();
+for (uint32_t i=0;i<n;i++)
+   {
+   minutes=i%(24*60);
+   seconds=i%60;
+   analog_displayDigitalClockOnScreen();
+   sink=analog_screen[7];
+   }
+return((double)(sim_nanos()-start)/n);
+}
+
+
+
+static double time_analog(uint32_t n)
+{
+uint64_t start=sim_nanos();
+for (uint32_t i=0;i<n;i++)
+   {
+   minutes=i%(12*60);
+   seconds=i%60;
+   displayAnalogClockOnScreen();
+   sink=analog_screen[7];
+   }
+return((double)(sim_nanos()-start)/n);
+}
+
+
+
+// the longest line, corner to corner
+static double time_line(uint32_t n)
+{
+uint64_t start=sim_nanos();
+for (uint32_t i=0;i<n;i++)
+   {
+   drawLine(0,i&15,15,15-(i&15));
+   sink=analog_screen[7];
+   }
+return((double)(sim_nanos()-start)/n);
+}
+
+
+
+static void report(const char *name,double ns)
+{
+printf("%-40s %8.1f ns\n",name,ns);
+sim_bench(name,ns);
+}
+
+
+
+int main(int argc, char **argv)
+{
+uint32_t n=250000;
+int opt;
+
+while ((opt=getopt(argc,argv,"n:o:"))!=-1)
+   {
+   switch (opt)
+      {
+	  case 'n':
+	     n=strtoul(optarg,NULL,0);
+		 break;
+	  case 'o':
+	     if (!sim_bench_open(optarg)) return(1);
+		 break;
+	  default:
+	     fprintf(stderr,"usage: %s [-n iterations] [-o results]\n",argv[0]);
+		 return(1);
+	  }
+   }
+
+sim_reset();
+printf("host time per call:\n");
+report("real_clock.displayDigitalClockOnScreen",sim_best(time_digital(n)));
+report("real_clock.screen_to_ports",sim_best(time_ports(n)));
+report("real_clock.show_row",sim_best(time_show_row(n)));
+report("real_clock.scan_row",sim_best(time_scan(n)));
+report("clock.displayDigitalClockOnScreen",sim_best(time_analog_digital(n)));
+report("clock.displayAnalogClockOnScreen",sim_best(time_analog(n)));
+report("clock.drawLine",sim_best(time_line(n)));
+return(0);
+}
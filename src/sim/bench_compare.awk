@@ -0,0 +1,38 @@
+# Compares two benchmark result files of sim_bench() lines, name and ns per
+# call. A name may appear once per run, the fastest run counts. Prints the
+# entries of the second file that are more than limit (default 0.5, 50%) and
+# more than floor ns (default 5) slower than in the first, and exits 1 if
+# there are any. The host's speed wanders by more than 20% between runs, the
+# limit is there to catch real regressions only.
+#
+# usage: awk [-v limit=0.5] [-v floor=5] -f bench_compare.awk base.tsv new.tsv
+
+BEGIN {
+	FS = "\t"
+	if (limit == "") limit = 0.5
+	if (floor == "") floor = 5
+}
+
+NR == FNR {
+	if (!($1 in base) || $2 < base[$1]) base[$1] = $2
+	next
+}
+
+{
+	if (!($1 in now)) order[n++] = $1
+	if (!($1 in now) || $2 < now[$1]) now[$1] = $2
+}
+
+END {
+	for (i = 0; i < n; i++) {
+		name = order[i]
+		if (!(name in base) || base[name] <= 0) continue
+		if (now[name] > base[name] * (1 + limit) && now[name] - base[name] > floor) {
+			printf "slower: %s %.1f ns, was %.1f ns (+%.0f%%)\n", name, now[name], base[name],
+			       100 * (now[name] / base[name] - 1)
+			slower++
+		}
+	}
+	if (slower) exit 1
+	print "no benchmark more than " 100 * limit "% slower than the base"
+}
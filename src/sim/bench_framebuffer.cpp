@@ -0,0 +1,182 @@
+// Checks Framebuffer (../framebuffer.hpp) against per-pixel reference code on
+// random frames, with 16-bit and 8-bit storage words, and times its row
+// operations and conversions on a 16x16 frame. to_l_port() is compared with
+// l2led() of the same pixels at full brightness.
+//
+// usage: bench_framebuffer [-n iterations] [-o results]
+//   -o  append the times to results, see sim_bench()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+extern "C" {
+#include "sim.h"
+#include "led.h"
+}
+#include "../framebuffer.hpp"
+
+using Frame = Framebuffer<16, ROWS>;
+using Frame8 = Framebuffer<16, ROWS, uint8_t>;
+using Sprite = Framebuffer<8, 5>;
+
+// Built at compile time, as script.hpp builds its blit frames.
+constexpr Frame diagonal() {
+  Frame f;
+  for (uint8_t i = 0; i < ROWS; ++i)
+    f.set(i, i);
+  return f;
+}
+static_assert(diagonal().count() == ROWS, "constexpr Framebuffer");
+static_assert(diagonal().port_word(0) == uint16_t(~(1 << FB_PORT_BIT[0])), "constexpr port_word");
+
+static bool pixel(const uint16_t *rows, uint8_t x, uint8_t y) { return rows[y] >> (15 - x) & 1; }
+
+static void random_rows(uint16_t *rows) {
+  for (uint8_t y = 0; y < ROWS; ++y)
+    rows[y] = rand();
+}
+
+template <class F> static bool check(const char *name) {
+  for (uint16_t n = 0; n < 500; ++n) {
+    const char *failed = NULL;
+    uint16_t rows[ROWS], back[ROWS];
+    random_rows(rows);
+
+    // screen[] rows of the clocks, get/set
+    F f = F::from_rows(rows);
+    f.to_rows(back);
+    if (memcmp(back, rows, sizeof(rows)))
+      failed = "to_rows";
+    for (uint8_t y = 0; y < ROWS; ++y)
+      for (uint8_t x = 0; x < 16; ++x)
+        if (f.get(x, y) != pixel(rows, x, y))
+          failed = "get";
+    F g;
+    for (uint8_t y = 0; y < ROWS; ++y)
+      for (uint8_t x = 0; x < 16; ++x)
+        g.set(x, y, pixel(rows, x, y));
+    if (g != f)
+      failed = "set";
+
+    // l[] of led.c: the lit pixels full on, the rest below the threshold
+    for (uint16_t i = 0; i < ROWS * ROWS; ++i)
+      l[i] = pixel(rows, i & 15, i >> 4) ? 15 : rand() % 15;
+    if (F::from_levels(l, 15) != f)
+      failed = "from_levels";
+    for (uint16_t i = 0; i < ROWS * ROWS; ++i)
+      if (l[i] != 15)
+        l[i] = 0;
+    l_dirty = 0xffff;
+    l2led();
+    uint8_t port[ROWS][LED_PLANES][2];
+    f.template to_l_port<LED_PLANES>(port);
+    if (memcmp(port, l_port, sizeof(port)))
+      failed = "to_l_port";
+    for (uint8_t y = 0; y < ROWS; ++y)
+      if (f.port_word(y) != (port[y][0][0] | port[y][0][1] << 8))
+        failed = "port_word";
+
+    // rotate_rows, either way and past the width
+    int8_t k = rand() % 40 - 20;
+    F r = f;
+    r.rotate_rows(k);
+    for (uint8_t y = 0; y < ROWS; ++y)
+      for (uint8_t x = 0; x < 16; ++x)
+        if (r.get(((x + k) % 16 + 16) % 16, y) != f.get(x, y))
+          failed = "rotate_rows";
+
+    // blit of a sprite partly or wholly off the frame
+    Sprite s;
+    for (uint8_t y = 0; y < 5; ++y)
+      for (uint8_t x = 0; x < 8; ++x)
+        s.set(x, y, rand() & 1);
+    int8_t bx = rand() % 28 - 14, by = rand() % 26 - 8;
+    BlitOp op = BlitOp(rand() % 4);
+    F b = f;
+    b.blit(s, bx, by, op);
+    for (uint8_t y = 0; y < ROWS; ++y)
+      for (uint8_t x = 0; x < 16; ++x) {
+        bool d = f.get(x, y), e = d;
+        int8_t sx = x - bx, sy = y - by;
+        if (sx >= 0 && sx < 8 && sy >= 0 && sy < 5) {
+          bool v = s.get(sx, sy);
+          e = op == BLIT_COPY ? v : op == BLIT_OR ? d | v : op == BLIT_XOR ? d ^ v : d & !v;
+        }
+        if (b.get(x, y) != e)
+          failed = "blit";
+      }
+
+    if ((~f).count() != ROWS * 16 - f.count())
+      failed = "~";
+    if (failed) {
+      printf("framebuffer: %s %s differs from the per-pixel version, case %u\n", name, failed, n);
+      return false;
+    }
+  }
+  return true;
+}
+
+// The fastest of SIM_BENCH_REPEATS runs of op, which changes the frame every
+// time so that the compiler cannot hoist the work out of the loop.
+template <class Op> static double time_ns(Frame &f, Op op, uint32_t n) {
+  double best = 1e30;
+  for (uint8_t r = 0; r < SIM_BENCH_REPEATS; ++r) {
+    uint64_t start = sim_nanos();
+    for (uint32_t i = 0; i < n; ++i) {
+      f.set(i & 15, (i >> 4) & 15, i & 0x100);
+      op(f, i);
+    }
+    double t = double(sim_nanos() - start) / n;
+    if (t < best)
+      best = t;
+  }
+  return best;
+}
+
+static void report(const char *name, double ns) {
+  printf("%-26s %8.1f ns\n", name, ns);
+  sim_bench(name, ns);
+}
+
+int main(int argc, char **argv) {
+  uint32_t n = 500000;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:o:")) != -1) {
+    if (opt == 'n') {
+      n = strtoul(optarg, NULL, 0);
+    } else if (opt == 'o') {
+      if (!sim_bench_open(optarg))
+        return 1;
+    } else {
+      fprintf(stderr, "usage: %s [-n iterations] [-o results]\n", argv[0]);
+      return 1;
+    }
+  }
+  sim_reset();
+  led_init();
+  srand(1);
+  if (!check<Frame>("16-bit words") || !check<Frame8>("8-bit words"))
+    return 1;
+
+  Frame f = diagonal();
+  Sprite s;
+  for (uint8_t i = 0; i < 5; ++i)
+    s.set(i, i);
+  uint16_t rows[ROWS];
+  uint8_t port[ROWS][LED_PLANES][2];
+  volatile uint16_t sink;
+  printf("16x16 Framebuffer, host time per call:\n");
+  report("framebuffer.set", time_ns(f, [](Frame &, uint32_t) {}, n));
+  report("framebuffer.rotate_rows", time_ns(f, [](Frame &x, uint32_t i) { x.rotate_rows(i & 7); }, n));
+  report("framebuffer.blit", time_ns(f, [&s](Frame &x, uint32_t i) { x.blit(s, i & 15, 3, BLIT_XOR); }, n));
+  report("framebuffer.to_rows", time_ns(f, [&rows](Frame &x, uint32_t) { x.to_rows(rows); }, n));
+  report("framebuffer.from_rows", time_ns(f, [&rows](Frame &x, uint32_t) { x = Frame::from_rows(rows); }, n));
+  report("framebuffer.to_l_port",
+         time_ns(f, [&port](Frame &x, uint32_t) { x.to_l_port<LED_PLANES>(port); }, n));
+  report("framebuffer.port_word",
+         time_ns(f, [&sink](Frame &x, uint32_t i) { sink = x.port_word(i & 15); }, n));
+  sink = rows[3] ^ port[5][0][0];
+  return 0;
+}
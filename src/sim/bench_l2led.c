@@ -0,0 +1,109 @@
+// Compares l2led() with the original per-pixel shift loop, both for identical
+// l_port output and for host time per full repack. On the host l2led() runs
+// the portable version of its AVR asm, the host times say nothing of the AVR
+// ones, see COLUMN_AT in led.c.
+//
+// usage: bench_l2led [-n iterations] [-o results]
+//   -o  append the times to results, see sim_bench()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "led.h"
+
+static uint8_t l_order[16]={1,3,5,7,9,11,13,15,0,2,4,14,12,10,8,6,};
+
+// l2led() as it was before the bitplane kernel
+static void l2led_loop(void)
+{
+uint8_t i,j,tmp;
+uint16_t tmp0,tmp1,tmp2,tmp3;
+for(j=0;j<16;j++)
+   {
+   tmp0=0;tmp1=0;tmp2=0;tmp3=0;
+   for(i=0;i<16;i++)
+      {
+	  tmp=l[j*16+l_order[i]];
+	  tmp0=(tmp0<<1)|((tmp&0x01) ? 0 : 1);
+	  tmp1=(tmp1<<1)|((tmp&0x02) ? 0 : 1);
+	  tmp2=(tmp2<<1)|((tmp&0x04) ? 0 : 1);
+	  tmp3=(tmp3<<1)|((tmp&0x08) ? 0 : 1);
+	  }
+   *(uint16_t *)&l_port[j][0][0]=tmp0;
+   *(uint16_t *)&l_port[j][1][0]=tmp1;
+   *(uint16_t *)&l_port[j][2][0]=tmp2;
+   *(uint16_t *)&l_port[j][3][0]=tmp3;
+   }
+}
+
+
+
+static void l2led_new(void)
+{
+l_dirty=0xffff;
+l2led();
+}
+
+
+
+static double time_ns(void (*kernel)(void),uint32_t n)
+{
+uint64_t start=sim_nanos();
+for (uint32_t i=0;i<n;i++)
+   {
+   l[i&0xff]=i>>8; // keep the compiler from hoisting the work out
+   kernel();
+   }
+return((double)(sim_nanos()-start)/n);
+}
+
+
+
+int main(int argc, char **argv)
+{
+uint32_t n=50000;
+int opt;
+uint8_t expect[sizeof(l_buffer[0])];
+double t_loop,t_new;
+
+while ((opt=getopt(argc,argv,"n:o:"))!=-1)
+   {
+   switch (opt)
+      {
+	  case 'n':
+	     n=strtoul(optarg,NULL,0);
+		 break;
+	  case 'o':
+	     if (!sim_bench_open(optarg)) return(1);
+		 break;
+	  default:
+	     fprintf(stderr,"usage: %s [-n iterations] [-o results]\n",argv[0]);
+		 return(1);
+	  }
+   }
+
+srand(1);
+for (uint16_t frame=0;frame<1000;frame++)
+   {
+   for (uint16_t i=0;i<ROWS*ROWS;i++) l[i]=rand();
+   l2led_loop();
+   memcpy(expect,l_port,sizeof(l_buffer[0]));
+   memset(l_port,0x55,sizeof(l_buffer[0]));
+   l2led_new();
+   if (memcmp(expect,l_port,sizeof(l_buffer[0])))
+      {
+	  printf("l2led: output differs from the original on frame %u\n",frame);
+	  return(1);
+	  }
+   }
+
+t_loop=sim_best(time_ns(l2led_loop,n));
+t_new=sim_best(time_ns(l2led_new,n));
+printf("l2led full repack: loop %.1f ns, l2led %.1f ns\n",t_loop,t_new);
+sim_bench("l2led.loop",t_loop);
+sim_bench("l2led",t_new);
+return(0);
+}
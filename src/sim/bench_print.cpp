@@ -0,0 +1,125 @@
+// Compares printLedArray() of the 3x3 Arduino sketch ../ledivilkku.cpp with
+// its direct port version printLedArray_fast(), both for identical PORTD
+// output and for host time per frame with no delay between the rows.
+//
+// usage: bench_print [-n iterations] [-o results]
+//   -o  append the times to results, see sim_bench()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+extern "C" {
+#include "sim.h"
+}
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <util/delay.h>
+
+// Stand-ins for the Arduino core the sketch is built with, digitalWrite()
+// doing what the Uno's does for pins 0 - 7: look the pin up, and change its
+// PORTD bit with the interrupts off.
+const uint8_t LOW = 0;
+const uint8_t HIGH = 1;
+const uint8_t OUTPUT = 1;
+const uint8_t B00011100 = 0x1c;
+
+const uint8_t pin_mask[8] PROGMEM = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80};
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  uint8_t mask = pgm_read_byte(&pin_mask[pin]);
+  uint8_t sreg = SREG;
+  cli();
+  if (mode == OUTPUT)
+    DDRD |= mask;
+  else
+    DDRD &= ~mask;
+  SREG = sreg;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  uint8_t mask = pgm_read_byte(&pin_mask[pin]);
+  uint8_t sreg = SREG;
+  cli();
+  if (value == LOW)
+    PORTD &= ~mask;
+  else
+    PORTD |= mask;
+  SREG = sreg;
+}
+
+void delayMicroseconds(unsigned int us) { _delay_us(us); }
+
+#include "../ledivilkku.cpp"
+
+// @brief The frame of led bits (bit x + 3y) as the bool array of printLedArray().
+static void to_bools(led_bit_t bits, bool *leds) {
+  for (idx_t i = 0; i < LED_COUNT; ++i)
+    leds[i] = bits & (1 << i);
+}
+
+static bool check() {
+  for (uint16_t bits = 0; bits < (1 << LED_COUNT); ++bits) {
+    bool leds[LED_COUNT];
+    to_bools(bits, leds);
+    PORTD = 0;
+    printLedArray(leds, 0);
+    uint8_t slow = PORTD;
+    PORTD = 0;
+    printLedArray_fast(bits, 0);
+    if (PORTD != slow) {
+      printf("print: printLedArray_fast differs from printLedArray on frame %03x\n", bits);
+      return false;
+    }
+  }
+  return true;
+}
+
+// The fastest of SIM_BENCH_REPEATS runs.
+template <class Op> static double time_ns(Op op, uint32_t n) {
+  double best = 1e30;
+  for (uint8_t r = 0; r < SIM_BENCH_REPEATS; ++r) {
+    uint64_t start = sim_nanos();
+    for (uint32_t i = 0; i < n; ++i)
+      op(i);
+    double t = double(sim_nanos() - start) / n;
+    if (t < best)
+      best = t;
+  }
+  return best;
+}
+
+int main(int argc, char **argv) {
+  uint32_t n = 500000;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:o:")) != -1) {
+    if (opt == 'n') {
+      n = strtoul(optarg, NULL, 0);
+    } else if (opt == 'o') {
+      if (!sim_bench_open(optarg))
+        return 1;
+    } else {
+      fprintf(stderr, "usage: %s [-n iterations] [-o results]\n", argv[0]);
+      return 1;
+    }
+  }
+  sim_reset();
+  setup();
+  if (!check())
+    return 1;
+  bool leds[LED_COUNT];
+  to_bools(0x0a5, leds);
+  double t_slow = time_ns(
+      [&leds](uint32_t i) {
+        leds[i % LED_COUNT] ^= 1; // keep the compiler from hoisting the work out
+        printLedArray(leds, 0);
+      },
+      n);
+  double t_fast = time_ns([](uint32_t i) { printLedArray_fast(i & 0x1ff, 0); }, n);
+  printf("3x3 frame: printLedArray %.1f ns, printLedArray_fast %.1f ns, %.2fx\n", t_slow,
+         t_fast, t_slow / t_fast);
+  sim_bench("print.printLedArray", t_slow);
+  sim_bench("print.printLedArray_fast", t_fast);
+  return 0;
+}
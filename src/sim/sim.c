@@ -0,0 +1,293 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <avr/io.h>
+
+#include "sim.h"
+
+// Firmware interrupt handlers, whichever the linked build provides
+void sim_timer1_compa_vect(void) __attribute__((weak));
+void sim_timer1_ovf_vect(void) __attribute__((weak));
+void sim_timer0_comp_vect(void) __attribute__((weak));
+
+volatile uint8_t sim_io[SIM_IO_SIZE];
+
+uint64_t sim_cycles;
+uint64_t sim_on[SIM_SIZE][SIM_SIZE];
+uint32_t sim_isr_calls;
+uint64_t sim_isr_cycles;
+uint32_t sim_isr_polls;
+
+static FILE *bench_file;
+static uint8_t  sim_pressed;
+static uint16_t t0_sub; // cycles counted towards the next Timer0 tick
+static uint16_t t1_sub; // cycles counted towards the next Timer1 tick
+
+struct pin {
+uint8_t addr;
+uint8_t bit;
+};
+
+// physical wiring from info/pins.txt, independent of the firmware tables
+static const struct pin rows[SIM_SIZE]={
+	{PORTA_ADDR,3},{PORTA_ADDR,4},{PORTA_ADDR,5},{PORTA_ADDR,6},
+	{PORTA_ADDR,7},{PORTE_ADDR,0},{PORTE_ADDR,1},{PORTE_ADDR,2},
+	{PORTC_ADDR,7},{PORTC_ADDR,6},{PORTC_ADDR,5},{PORTC_ADDR,4},
+	{PORTC_ADDR,3},{PORTC_ADDR,2},{PORTC_ADDR,1},{PORTC_ADDR,0}};
+
+static const struct pin columns[SIM_SIZE]={
+	{PORTA_ADDR,2},{PORTD_ADDR,7},{PORTA_ADDR,1},{PORTD_ADDR,6},
+	{PORTA_ADDR,0},{PORTD_ADDR,5},{PORTB_ADDR,0},{PORTD_ADDR,4},
+	{PORTB_ADDR,1},{PORTD_ADDR,3},{PORTB_ADDR,2},{PORTD_ADDR,2},
+	{PORTB_ADDR,3},{PORTD_ADDR,1},{PORTB_ADDR,4},{PORTD_ADDR,0}};
+
+
+
+void sim_reset(void)
+{
+memset((void *)sim_io,0,sizeof(sim_io));
+PIND=0xff;
+sim_pressed=0;
+t0_sub=0;
+t1_sub=0;
+sim_cycles=0;
+sim_clear_stats();
+}
+
+
+
+void sim_clear_stats(void)
+{
+memset(sim_on,0,sizeof(sim_on));
+sim_isr_calls=0;
+sim_isr_cycles=0;
+sim_isr_polls=0;
+}
+
+
+
+void sim_button(uint8_t pressed)
+{
+sim_pressed=pressed;
+}
+
+
+
+uint64_t sim_nanos(void)
+{
+struct timespec ts;
+clock_gettime(CLOCK_MONOTONIC,&ts);
+return((uint64_t)ts.tv_sec*1000000000u+ts.tv_nsec);
+}
+
+
+
+int sim_bench_open(const char *path)
+{
+bench_file=fopen(path,"a");
+if (!bench_file)
+   {
+   perror(path);
+   return(0);
+   }
+return(1);
+}
+
+
+
+void sim_bench(const char *name, double ns)
+{
+if (!bench_file) return;
+fprintf(bench_file,"%s\t%.1f\n",name,ns);
+fflush(bench_file);
+}
+
+
+
+// a LED is lit when its cathode (row) is driven high and its anode (column) low
+static void record(uint32_t cycles)
+{
+for (uint8_t y=0;y<SIM_SIZE;y++)
+   {
+   if (!(sim_io[rows[y].addr]&(1<<rows[y].bit))) continue;
+   for (uint8_t x=0;x<SIM_SIZE;x++)
+      {
+	  if (!(sim_io[columns[x].addr]&(1<<columns[x].bit))) sim_on[y][x]+=cycles;
+	  }
+   }
+sim_cycles+=cycles;
+}
+
+
+
+static uint16_t prescale(uint8_t cs)
+{
+static const uint16_t prescale[8]={0,1,8,64,256,1024,0,0};
+return(prescale[cs&0x07]);
+}
+
+
+
+// cycles until the next Timer0 compare match in CTC mode, or 0 when the
+// timer cannot raise an enabled interrupt
+static uint32_t t0_due(void)
+{
+uint16_t p=prescale(TCCR0);
+uint32_t ticks;
+if (!p || !(SREG&0x80)) return(0);
+if (!(TCCR0&(1<<WGM01)) || !(TIMSK&(1<<OCIE0))) return(0);
+if (TCNT0<=OCR0) ticks=(uint32_t)OCR0+1-TCNT0;
+else ticks=0x100u-TCNT0+OCR0+1;
+return(ticks*p-t0_sub);
+}
+
+
+
+static void t0_advance(uint32_t cycles)
+{
+uint16_t p=prescale(TCCR0);
+if (!p) return;
+cycles+=t0_sub;
+TCNT0+=cycles/p;
+t0_sub=cycles%p;
+}
+
+
+
+// cycles until the next Timer1 event (compare match in CTC mode, otherwise
+// overflow), or 0 when the timer cannot raise an enabled interrupt
+static uint32_t t1_due(void)
+{
+uint16_t p=prescale(TCCR1B);
+uint32_t ticks;
+if (!p || !(SREG&0x80)) return(0);
+if (TCCR1B&(1<<WGM12))
+   {
+   if (!(TIMSK&(1<<OCIE1A))) return(0);
+   if (TCNT1<=OCR1A) ticks=(uint32_t)OCR1A+1-TCNT1;
+   else ticks=0x10000u-TCNT1+OCR1A+1;
+   }
+else
+   {
+   if (!(TIMSK&(1<<TOIE1))) return(0);
+   ticks=0x10000u-TCNT1;
+   }
+return(ticks*p-t1_sub);
+}
+
+
+
+static void t1_advance(uint32_t cycles)
+{
+uint16_t p=prescale(TCCR1B);
+if (!p) return;
+cycles+=t1_sub;
+TCNT1+=cycles/p;
+t1_sub=cycles%p;
+}
+
+
+
+// runs an interrupt handler with interrupts disabled
+static void serve(void (*vector)(void))
+{
+uint64_t start=sim_cycles;
+sim_isr_calls++;
+SREG&=~0x80;
+if (vector) vector();
+SREG|=0x80;
+if (sim_cycles!=start)
+   {
+   sim_isr_cycles+=sim_cycles-start;
+   sim_isr_polls++;
+   }
+}
+
+
+
+static void t1_fire(void)
+{
+TCNT1=0;
+t1_sub=0;
+serve((TCCR1B&(1<<WGM12)) ? sim_timer1_compa_vect : sim_timer1_ovf_vect);
+}
+
+
+
+static void t0_fire(void)
+{
+TCNT0=0;
+t0_sub=0;
+serve(sim_timer0_comp_vect);
+}
+
+
+
+static void pins_in(void)
+{
+PIND=sim_pressed ? (uint8_t)~0x04 : 0xff;
+}
+
+
+
+// cycles to the next interrupt of either timer, 0 if none can come
+static uint32_t next_due(uint32_t d0, uint32_t d1)
+{
+if (!d0) return(d1);
+if (!d1) return(d0);
+return((d0<d1) ? d0 : d1);
+}
+
+
+
+// lets cycles pass and serves the interrupts that come due at the end of
+// them, d0 and d1 as from t0_due() and t1_due() - Timer1 has the priority
+static void run(uint32_t cycles, uint32_t d0, uint32_t d1)
+{
+record(cycles);
+t0_advance(cycles);
+t1_advance(cycles);
+if ((d0!=cycles) && (d1!=cycles)) return;
+pins_in();
+if (d1==cycles) t1_fire();
+if (d0==cycles) t0_fire();
+}
+
+
+
+// busy wait: time passes, interrupts are served as they come due
+void sim_delay(uint32_t cycles)
+{
+while (cycles)
+   {
+   uint32_t d0=t0_due();
+   uint32_t d1=t1_due();
+   uint32_t due=next_due(d0,d1);
+   if ((due==0) || (due>cycles))
+      {
+	  run(cycles,0,0);
+	  return;
+	  }
+   run(due,d0,d1);
+   cycles-=due;
+   }
+}
+
+
+
+// idle until the next interrupt has been served, used by the busy-wait loops
+// of the firmware that poll variables set by an interrupt
+void sim_step(void)
+{
+uint32_t d0=t0_due();
+uint32_t d1=t1_due();
+uint32_t due=next_due(d0,d1);
+if (due==0)
+   {
+   fprintf(stderr,"sim: waiting for an interrupt that can never come\n");
+   exit(1);
+   }
+run(due,d0,d1);
+}
@@ -0,0 +1,44 @@
+// Host simulator for the LED matrix boards: a register file standing in
+// for the ATmega162 I/O space, Timer0 and Timer1 models that call the
+// firmware interrupt handlers, and per-LED on-time bookkeeping.
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+
+#ifndef SIM_F_CPU
+#define SIM_F_CPU 8000000UL
+#endif
+
+#define SIM_IO_SIZE 0x60
+#define SIM_SIZE 16
+
+extern volatile uint8_t sim_io[SIM_IO_SIZE];
+
+extern uint64_t sim_cycles;                   // simulated time since sim_reset()
+extern uint64_t sim_on[SIM_SIZE][SIM_SIZE];   // cycles each LED has been lit, [y][x]
+extern uint32_t sim_isr_calls;                // interrupts served since sim_reset()
+extern uint64_t sim_isr_cycles;               // of sim_cycles, spent polling inside interrupts
+extern uint32_t sim_isr_polls;                // interrupts that polled
+
+void sim_reset(void);
+void sim_clear_stats(void);
+void sim_delay(uint32_t cycles);
+void sim_step(void);
+void sim_button(uint8_t pressed);
+uint64_t sim_nanos(void);
+
+// Benchmark results: after sim_bench_open(path) every sim_bench() appends a
+// "name<TAB>ns per call" line to path, for comparing runs.
+int sim_bench_open(const char *path);
+void sim_bench(const char *name, double ns);
+
+// A benchmark times SIM_BENCH_REPEATS runs and keeps the fastest, the one the
+// host disturbed least: sim_best(t) of the timing expression t
+#define SIM_BENCH_REPEATS 7
+#define sim_best(t) __extension__({double best_=1e30; \
+   for (uint8_t rep_=0;rep_<SIM_BENCH_REPEATS;rep_++) {double t_=(t); if (t_<best_) best_=t_;} \
+   best_;})
+
+#endif
@@ -0,0 +1,93 @@
+// Runs the animation firmware of src/ref on the host simulator and prints
+// how long every LED was lit.
+//
+// usage: simulate [-t ticks] [-s sequence] [-m] [-c hhmmss]
+//   -t  number of led ticks (full scans of all bitplanes) to run, default 256
+//   -s  animation sequence to start from, default 0
+//   -m  run matrix() instead of animate()
+//   -c  show the clock face of face.c at hh:mm:ss instead of animating
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "led.h"
+#include "face.h"
+
+// from ledivilkku.c
+extern uint8_t animationsequence;
+void setup(void);
+void tick(void);
+void animate(void);
+void matrix(void);
+void setanimation(void);
+
+
+
+int main(int argc, char **argv)
+{
+uint32_t ticks=256;
+uint8_t use_matrix=0;
+long face=-1;
+int opt;
+uint64_t start,busy=0;
+
+sim_reset();
+setup();
+while ((opt=getopt(argc,argv,"t:s:mc:"))!=-1)
+   {
+   switch (opt)
+      {
+	  case 't':
+	     ticks=strtoul(optarg,NULL,0);
+		 break;
+	  case 's':
+	     animationsequence=strtoul(optarg,NULL,0);
+		 setanimation();
+		 break;
+	  case 'm':
+	     use_matrix=1;
+		 break;
+	  case 'c':
+	     face=strtol(optarg,NULL,10);
+		 break;
+	  default:
+	     fprintf(stderr,"usage: %s [-t ticks] [-s sequence] [-m] [-c hhmmss]\n",argv[0]);
+		 return(1);
+	  }
+   }
+sim_clear_stats();
+for (uint32_t i=0;i<ticks;i++)
+   {
+   start=sim_nanos();
+   if (face>=0)
+      {
+	  face_draw(face/10000,face/100%100,face%100);
+	  l2led();
+	  }
+   else if (use_matrix) matrix();
+   else animate();
+   busy+=sim_nanos()-start;
+   tick();
+   }
+
+// duty of every LED in 1/256 of simulated time, the brightest possible is
+// 1/16 (one row of 16 lit at a time), printed as 0x10
+// interrupt load: LED_ISR_CYCLES per interrupt, the polled phases as simulated
+printf("simulated %llu cycles (%.1f ms), %u interrupts, %.0f ns host time per %s(), "
+   "%d planes ISR load %.1f%%\n",
+   (unsigned long long)sim_cycles,sim_cycles*1000.0/SIM_F_CPU,sim_isr_calls,
+   (double)busy/ticks,(face>=0) ? "face_draw" : use_matrix ? "matrix" : "animate",LED_PLANES,
+   100.0*((double)sim_isr_calls*LED_ISR_CYCLES+(double)sim_isr_polls*LED_FAST_EXTRA+
+   sim_isr_cycles)/sim_cycles);
+for (uint8_t y=0;y<SIM_SIZE;y++)
+   {
+   for (uint8_t x=0;x<SIM_SIZE;x++)
+      {
+	  printf(" %02x",(unsigned)(sim_on[y][x]*256/sim_cycles));
+	  }
+   printf("\n");
+   }
+return(0);
+}
@@ -0,0 +1,12 @@
+// Host simulator stand-in for <util/delay.h>. Busy waits advance the
+// simulated clock with the ports as they are.
+
+#ifndef SIM_UTIL_DELAY_H
+#define SIM_UTIL_DELAY_H
+
+#include "sim.h"
+
+#define _delay_us(us) sim_delay((uint32_t)((us)*(SIM_F_CPU/1000000UL)))
+#define _delay_ms(ms) sim_delay((uint32_t)((ms)*(SIM_F_CPU/1000UL)))
+
+#endif